@@ -0,0 +1,625 @@
+/* AVL Trees library contributors
+ * Creation Date: 17/10/2026
+ * Latest Version: 17/10/2026
+ * ----------------------------------------------------------------------------
+ * This is the main source file for the AVL Trees library with binary keys.
+ * Keys are compared with memcmp, knowing their lengths, so they can hold any
+ * byte and need no terminator.
+ * See the comments above each function definition for information about what
+ * each one does. See the library header file for a brief description of the
+ * "AVL Tree" data type.
+ */
+/* This code is released under the MIT license.
+ * See the attached LICENSE file.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include "AVLTree_BinaryKeys.h"
+
+/* Macro to find the maximum between two integers. */
+#define MAX(X, Y) ((X) <= (Y) ? (Y) : (X))
+
+/* Internal library subroutines declarations. */
+AVLBinNode *_createBinNode(void *newKey, unsigned long int len,
+                           void *newData);
+void _deleteBinNode(AVLBinNode *node);
+AVLBinNode *_searchBinNode(AVLBinTree *tree, const void *key,
+                           unsigned long int len);
+int _binCompare(AVLBinNode *node, const void *key, unsigned long int len);
+void _binInsertAsLeftSubtree(AVLBinNode *father, AVLBinNode *newSon);
+void _binInsertAsRightSubtree(AVLBinNode *father, AVLBinNode *newSon);
+AVLBinNode *_binCutLeftSubtree(AVLBinNode *father);
+AVLBinNode *_binCutRightSubtree(AVLBinNode *father);
+AVLBinNode *_binCutSubtree(AVLBinNode *node);
+AVLBinNode *_binMaxKeySon(AVLBinNode *node);
+void _binReplaceSubtree(AVLBinTree *tree, AVLBinNode *node,
+                        AVLBinNode *newNode);
+void _binDeleteNode(AVLBinTree *tree, AVLBinNode *node);
+int _binHeight(AVLBinNode *node);
+unsigned long int _binSize(AVLBinNode *node);
+void _binSetHeight(AVLBinNode *node, int newHeight);
+int _binBalanceFactor(AVLBinNode *node);
+void _binUpdateHeight(AVLBinNode *node);
+void _binRightRotation(AVLBinTree *tree, AVLBinNode *node);
+void _binLeftRotation(AVLBinTree *tree, AVLBinNode *node);
+AVLBinNode *_binRotate(AVLBinTree *tree, AVLBinNode *node);
+void _binBalanceInsert(AVLBinTree *tree, AVLBinNode *newNode);
+void _binBalanceDelete(AVLBinTree *tree, AVLBinNode *remFather);
+void _binInODFS(AVLBinNode *rootNode, void ***intPtr, int intOpt);
+void _binPreODFS(AVLBinNode *rootNode, void ***intPtr, int intOpt);
+void _binPostODFS(AVLBinNode *rootNode, void ***intPtr, int intOpt);
+
+// USER FUNCTIONS //
+/* Creates a new AVL Tree in the heap. */
+AVLBinTree *createBinTree(void) {
+    AVLBinTree *newTree = (AVLBinTree *) malloc(sizeof(AVLBinTree));
+    if (newTree == NULL) return NULL;
+    newTree->_root = NULL;
+    newTree->nodesCount = 0;
+    newTree->maxNodes = ULONG_MAX;
+    return newTree;
+}
+
+/* Frees a given AVL Tree from the heap. Using options defined in the header,
+ * it's possible to specify whether also keys and/or data have to be freed or
+ * not.
+ */
+int deleteBinTree(AVLBinTree *tree, int opts) {
+    // Sanity check on input arguments.
+    if (tree == NULL) return -1;
+    if (opts < 0) return -1;
+    // If the tree is empty free it directly.
+    if (tree->_root == NULL) {
+        free(tree);
+        return 0;
+    }
+    // Do a BFS to get all the nodes (less taxing on memory than a DFS).
+    AVLBinNode **nodes = (AVLBinNode **) binBFS(tree, BFS_LEFT_FIRST,
+                                                SEARCH_NODES);
+    // Free the nodes and eventually their keys/data.
+    for (unsigned long int i = 0; i < tree->nodesCount; i++) {
+        if (opts & DELETE_FREE_KEYS) free((*(nodes[i]))._key.bytes);
+        if (opts & DELETE_FREE_DATA) free((*(nodes[i]))._data);
+        _deleteBinNode(nodes[i]);
+    }
+    // Free the nodes array and the tree, and that's it!
+    free(nodes);
+    free(tree);
+    return 0;
+}
+
+/* Searches for an entry with the specified key, of the given length, in the
+ * tree. Searching keys returns the key stored in the tree, as a pointer to an
+ * AVLBinKey.
+ */
+void *binSearch(AVLBinTree *tree, const void *key, unsigned long int len,
+                int opts) {
+    // Sanity check on input arguments.
+    if ((opts <= 0) || (tree == NULL)) return NULL;
+    if ((key == NULL) && (len > 0)) return NULL;
+    AVLBinNode *searchedNode = _searchBinNode(tree, key, len);
+    if (searchedNode != NULL) {
+        if (opts & SEARCH_DATA) return searchedNode->_data;
+        if (opts & SEARCH_KEYS) return &(searchedNode->_key);
+        if (opts & SEARCH_NODES) return searchedNode;
+        return NULL;
+    }
+    return NULL;
+}
+
+/* Deletes an entry from the tree. */
+int binDelete(AVLBinTree *tree, const void *key, unsigned long int len,
+              int opts) {
+    // Sanity check on input arguments.
+    if ((opts < 0) || (tree == NULL)) return 0;
+    if ((key == NULL) && (len > 0)) return 0;
+    AVLBinNode *toDelete = _searchBinNode(tree, key, len);
+    if (toDelete != NULL) {
+        // Unlink the node, then apply eventual options to free keys and data,
+        // then free the node.
+        _binDeleteNode(tree, toDelete);
+        if (opts & DELETE_FREE_DATA) free(toDelete->_data);
+        if (opts & DELETE_FREE_KEYS) free(toDelete->_key.bytes);
+        _deleteBinNode(toDelete);
+        tree->nodesCount--;
+        return 1;  // Found and deleted.
+    }
+    return 0;  // Not found.
+}
+
+/* Creates and inserts a new node in the tree, with a key of the given length.
+ * The key is not copied, so its bytes must stay where they are while the
+ * entry is in the tree.
+ * Returns the new number of entries, or 0 if the insertion failed.
+ */
+unsigned long int binInsert(AVLBinTree *tree, void *newKey,
+                            unsigned long int len, void *newData) {
+    // Sanity check on input arguments.
+    if ((tree == NULL) || ((newKey == NULL) && (len > 0))) return 0;
+    if (tree->nodesCount == tree->maxNodes) return 0;  // The tree is full.
+    AVLBinNode *newNode = _createBinNode(newKey, len, newData);
+    if (newNode == NULL) return 0;
+    if (tree->_root == NULL) {
+        // The tree is empty.
+        tree->_root = newNode;
+        tree->nodesCount++;
+    } else {
+        // Look for the correct position and place it there.
+        AVLBinNode *curr = tree->_root;
+        AVLBinNode *pred = NULL;
+        int comp;
+        while (curr != NULL) {
+            pred = curr;
+            comp = _binCompare(curr, newKey, len);
+            if (comp >= 0) {
+                // Equals are kept in the left subtree.
+                curr = curr->_leftSon;
+            } else {
+                curr = curr->_rightSon;
+            }
+        }
+        comp = _binCompare(pred, newKey, len);
+        if (comp >= 0) {
+            _binInsertAsLeftSubtree(pred, newNode);
+        } else {
+            _binInsertAsRightSubtree(pred, newNode);
+        }
+        _binBalanceInsert(tree, newNode);
+        tree->nodesCount++;
+    }
+    return tree->nodesCount;  // Return the result of the insertion.
+}
+
+/* Performs a depth-first search of the tree, the type of which can be
+ * specified using the options defined in the header.
+ * Depending on the option specified, returns an array of:
+ * - Pointers to the nodes.
+ * - Pointers to the keys, as AVLBinKeys stored in the nodes.
+ * - Data.
+ * See the header for the definitions of such options.
+ * Remember to free the returned array afterwards!
+ */
+void **binDFS(AVLBinTree *tree, int type, int opts) {
+    // Sanity check for the input arguments.
+    if ((type <= 0) || (opts <= 0)) return NULL;
+    if ((tree == NULL) || (tree->_root == NULL)) return NULL;
+    // Allocate memory according to options.
+    void **dfsRes;
+    int intOpt;
+    if (opts & SEARCH_DATA) {
+        intOpt = SEARCH_DATA;
+        dfsRes = calloc(tree->nodesCount, sizeof(void *));
+    } else if (opts & SEARCH_KEYS) {
+        intOpt = SEARCH_KEYS;
+        dfsRes = calloc(tree->nodesCount, sizeof(AVLBinKey *));
+    } else if (opts & SEARCH_NODES) {
+        intOpt = SEARCH_NODES;
+        dfsRes = calloc(tree->nodesCount, sizeof(AVLBinNode *));
+    } else return NULL;  // Invalid option.
+    if (dfsRes == NULL) return NULL;  // calloc failed.
+    // Launch the requested DFS according to type.
+    void **intPtr = dfsRes;
+    if (type & DFS_PRE_ORDER) {
+        _binPreODFS(tree->_root, &intPtr, intOpt);
+    } else if (type & DFS_IN_ORDER) {
+        _binInODFS(tree->_root, &intPtr, intOpt);
+    } else if (type & DFS_POST_ORDER) {
+        _binPostODFS(tree->_root, &intPtr, intOpt);
+    } else {
+        // Invalid type.
+        free(dfsRes);
+        return NULL;
+    }
+    // The array is now filled with the requested data.
+    return dfsRes;
+}
+
+/* Performs a breadth-first search of the tree, the type of which can be
+ * specified using the options defined in the header (left or right son
+ * visited first).
+ * Depending on the option specified, returns an array of:
+ * - Pointers to the nodes.
+ * - Pointers to the keys, as AVLBinKeys stored in the nodes.
+ * - Data.
+ * See the header for the definitions of such options.
+ * Remember to free the returned array afterwards!
+ */
+void **binBFS(AVLBinTree *tree, int type, int opts) {
+    // Sanity check on input arguments.
+    if ((tree == NULL) || (tree->_root == NULL) ||
+        (type <= 0) || (opts <= 0) ||
+        !((type & BFS_LEFT_FIRST) || (type & BFS_RIGHT_FIRST)) ||
+        !((opts & SEARCH_KEYS) || (opts & SEARCH_DATA) ||
+        (opts & SEARCH_NODES))) return NULL;
+    // Allocate memory in the heap.
+    void **bfsRes = NULL;
+    void **intPtr;
+    if (opts & SEARCH_DATA) {
+        bfsRes = calloc(tree->nodesCount, sizeof(void *));
+    } else if (opts & SEARCH_KEYS) {
+        bfsRes = calloc(tree->nodesCount, sizeof(AVLBinKey *));
+    } else if (opts & SEARCH_NODES) {
+        bfsRes = calloc(tree->nodesCount, sizeof(AVLBinNode *));
+    } else return NULL;  // Invalid option.
+    if (bfsRes == NULL) return NULL;  // Calloc failed.
+    intPtr = bfsRes + 1;
+    *bfsRes = (void *) (tree->_root);
+    AVLBinNode *curr;
+    // Start the visit, using the same array to return as a temporary queue
+    // for the nodes.
+    for (unsigned long int i = 0; i < tree->nodesCount; i++) {
+        curr = (AVLBinNode *) bfsRes[i];
+        // Visit the current node.
+        if (opts & SEARCH_DATA) {
+            bfsRes[i] = curr->_data;
+        } else if (opts & SEARCH_KEYS) {
+            bfsRes[i] = &(curr->_key);
+        } else if (opts & SEARCH_NODES) {
+            bfsRes[i] = curr;
+        }
+        // Eventually add the sons to the array, to be visited afterwards.
+        if (type & BFS_LEFT_FIRST) {
+            if (curr->_leftSon != NULL) {
+                *intPtr = (void *) (curr->_leftSon);
+                intPtr++;
+            }
+            if (curr->_rightSon != NULL) {
+                *intPtr = (void *) (curr->_rightSon);
+                intPtr++;
+            }
+        } else if (type & BFS_RIGHT_FIRST) {
+            if (curr->_rightSon != NULL) {
+                *intPtr = (void *) (curr->_rightSon);
+                intPtr++;
+            }
+            if (curr->_leftSon != NULL) {
+                *intPtr = (void *) (curr->_leftSon);
+                intPtr++;
+            }
+        }
+    }
+    return bfsRes;
+}
+
+// INTERNAL LIBRARY SUBROUTINES //
+/* Creates a new node in the heap. */
+AVLBinNode *_createBinNode(void *newKey, unsigned long int len,
+                           void *newData) {
+    AVLBinNode *newNode = (AVLBinNode *) malloc(sizeof(AVLBinNode));
+    if (newNode == NULL) return NULL;
+    newNode->_father = NULL;
+    newNode->_leftSon = NULL;
+    newNode->_rightSon = NULL;
+    newNode->_key.bytes = newKey;
+    newNode->_key.len = len;
+    newNode->_data = newData;
+    newNode->_height = 0;
+    newNode->_size = 1;
+    return newNode;
+}
+
+/* Frees memory occupied by a node. */
+void _deleteBinNode(AVLBinNode *node) {
+    free(node);
+}
+
+/* Inserts a subtree rooted in a given node as the left subtree of a given
+ * node.
+ */
+void _binInsertAsLeftSubtree(AVLBinNode *father, AVLBinNode *newSon) {
+    if (newSon != NULL) newSon->_father = father;
+    father->_leftSon = newSon;
+}
+
+/* Inserts a subtree rooted in a given node as the right subtree of a given
+ * node.
+ */
+void _binInsertAsRightSubtree(AVLBinNode *father, AVLBinNode *newSon) {
+    if (newSon != NULL) newSon->_father = father;
+    father->_rightSon = newSon;
+}
+
+/* Cuts and returns the left subtree of a given node. */
+AVLBinNode *_binCutLeftSubtree(AVLBinNode *father) {
+    AVLBinNode *son = father->_leftSon;
+    if (son == NULL) return NULL;  // Sanity check.
+    son->_father = NULL;
+    father->_leftSon = NULL;
+    return son;
+}
+
+/* Cuts and returns the right subtree of a given node. */
+AVLBinNode *_binCutRightSubtree(AVLBinNode *father) {
+    AVLBinNode *son = father->_rightSon;
+    if (son == NULL) return NULL;  // Sanity check.
+    son->_father = NULL;
+    father->_rightSon = NULL;
+    return son;
+}
+
+/* Cuts and returns the subtree nested in a given node. */
+AVLBinNode *_binCutSubtree(AVLBinNode *node) {
+    if (node == NULL) return NULL;  // Sanity check.
+    if (node->_father == NULL) return node;  // Asked to cut at root.
+    AVLBinNode *father = node->_father;
+    if ((node->_leftSon == NULL) && (node->_rightSon == NULL)) {
+        // The node is a leaf: distinguish between the node being a left or
+        // right son and cut accordingly.
+        if (father->_rightSon == node) {
+            father->_rightSon = NULL;
+        } else father->_leftSon = NULL;
+        node->_father = NULL;
+        return node;
+    } else if (father->_leftSon == node) return _binCutLeftSubtree(father);
+    return _binCutRightSubtree(father);
+}
+
+/* Returns the descendant of a given node with the greatest key. */
+AVLBinNode *_binMaxKeySon(AVLBinNode *node) {
+    AVLBinNode *curr = node;
+    while (curr->_rightSon != NULL) curr = curr->_rightSon;
+    return curr;
+}
+
+/* Returns a pointer to the node with the specified key, or NULL. */
+AVLBinNode *_searchBinNode(AVLBinTree *tree, const void *key,
+                           unsigned long int len) {
+    AVLBinNode *curr = tree->_root;
+    int comp;
+    while (curr != NULL) {
+        comp = _binCompare(curr, key, len);
+        if (comp > 0) {
+            curr = curr->_leftSon;
+        } else if (comp < 0) {
+            curr = curr->_rightSon;
+        } else return curr;
+    }
+    return NULL;
+}
+
+/* Compares the key of a node with a given one, of the given length, returning
+ * a value greater than, equal to or less than 0 like memcmp does. Bytes are
+ * compared up to the end of the shorter key, which comes first if they match.
+ */
+int _binCompare(AVLBinNode *node, const void *key, unsigned long int len) {
+    unsigned long int minLen = node->_key.len < len ? node->_key.len : len;
+    int comp = (minLen > 0) ? memcmp(node->_key.bytes, key, minLen) : 0;
+    if (comp != 0) return comp;
+    return (node->_key.len > len) - (node->_key.len < len);
+}
+
+/* Returns the height of a given node. */
+int _binHeight(AVLBinNode *node) {
+    if (node == NULL) {
+        return -1;  // Useful when computing balance factors.
+    }
+    return node->_height;
+}
+
+/* Returns the number of nodes in the subtree rooted in a given node. */
+unsigned long int _binSize(AVLBinNode *node) {
+    if (node == NULL) return 0;
+    return node->_size;
+}
+
+/* Sets the height of the specified node to the given value. */
+void _binSetHeight(AVLBinNode *node, int newHeight) {
+    if (node != NULL) node->_height = newHeight;
+}
+
+/* Returns the balance factor of a given node. */
+int _binBalanceFactor(AVLBinNode *node) {
+    if (node == NULL) return 0;  // Consistency check.
+    return _binHeight(node->_leftSon) - _binHeight(node->_rightSon);
+}
+
+/* Updates the height and the subtree size of a given node. */
+void _binUpdateHeight(AVLBinNode *node) {
+    if (node != NULL) {
+        _binSetHeight(node, MAX(_binHeight(node->_leftSon),
+                                _binHeight(node->_rightSon)) + 1);
+        node->_size = _binSize(node->_leftSon) + _binSize(node->_rightSon) + 1;
+    }
+}
+
+/* Puts the subtree rooted in a given node in the place of another node, which
+ * is left detached from its father.
+ */
+void _binReplaceSubtree(AVLBinTree *tree, AVLBinNode *node,
+                        AVLBinNode *newNode) {
+    AVLBinNode *father = node->_father;
+    node->_father = NULL;
+    if (father == NULL) {
+        if (newNode != NULL) newNode->_father = NULL;
+        tree->_root = newNode;
+    } else if (father->_leftSon == node) {
+        _binInsertAsLeftSubtree(father, newNode);
+    } else _binInsertAsRightSubtree(father, newNode);
+}
+
+/* Performs a simple right rotation at the specified node.
+ * Nodes are relinked rather than having their contents swapped, so that
+ * pointers to them stay valid.
+ */
+void _binRightRotation(AVLBinTree *tree, AVLBinNode *node) {
+    AVLBinNode *leftSon = node->_leftSon;
+    // Make the son climb in place of the node.
+    _binReplaceSubtree(tree, node, leftSon);
+    // Recombine portions to respect the search property.
+    _binInsertAsLeftSubtree(node, _binCutRightSubtree(leftSon));
+    _binInsertAsRightSubtree(leftSon, node);
+    // Update the height of the involved nodes.
+    _binUpdateHeight(node);
+    _binUpdateHeight(leftSon);
+}
+
+/* Performs a simple left rotation at the specified node.
+ * Nodes are relinked rather than having their contents swapped, so that
+ * pointers to them stay valid.
+ */
+void _binLeftRotation(AVLBinTree *tree, AVLBinNode *node) {
+    AVLBinNode *rightSon = node->_rightSon;
+    // Make the son climb in place of the node.
+    _binReplaceSubtree(tree, node, rightSon);
+    // Recombine portions to respect the search property.
+    _binInsertAsRightSubtree(node, _binCutLeftSubtree(rightSon));
+    _binInsertAsLeftSubtree(rightSon, node);
+    // Update the height of the involved nodes.
+    _binUpdateHeight(node);
+    _binUpdateHeight(rightSon);
+}
+
+/* Examines the balance factor of a given node and eventually rotates.
+ * Returns the node that is now at the top of the subtree.
+ */
+AVLBinNode *_binRotate(AVLBinTree *tree, AVLBinNode *node) {
+    int balFactor = _binBalanceFactor(node);
+    if (balFactor == 2) {
+        if (_binBalanceFactor(node->_leftSon) >= 0) {
+            // LL displacement: rotate right.
+            _binRightRotation(tree, node);
+        } else {
+            // LR displacement: apply double rotation.
+            _binLeftRotation(tree, node->_leftSon);
+            _binRightRotation(tree, node);
+        }
+    } else if (balFactor == -2) {
+        if (_binBalanceFactor(node->_rightSon) <= 0) {
+            // RR displacement: rotate left.
+            _binLeftRotation(tree, node);
+        } else {
+            // RL displacement: apply double rotation.
+            _binRightRotation(tree, node->_rightSon);
+            _binLeftRotation(tree, node);
+        }
+    } else return node;
+    return node->_father;
+}
+
+/* Updates heights and looks for displacements following an insertion. */
+void _binBalanceInsert(AVLBinTree *tree, AVLBinNode *newNode) {
+    AVLBinNode *curr = newNode->_father;
+    while (curr != NULL) {
+        if (abs(_binBalanceFactor(curr)) >= 2) {
+            // Unbalanced node found: the rotation restores the height the
+            // subtree had before the insertion, but the sizes of the nodes
+            // above still have to be updated.
+            curr = _binRotate(tree, curr);
+        } else _binUpdateHeight(curr);
+        curr = curr->_father;
+    }
+}
+
+/* Updates heights and looks for displacements following a deletion. */
+void _binBalanceDelete(AVLBinTree *tree, AVLBinNode *remFather) {
+    AVLBinNode *curr = remFather;
+    while (curr != NULL) {
+        if (abs(_binBalanceFactor(curr)) >= 2) {
+            // There may be more than one unbalanced node.
+            curr = _binRotate(tree, curr);
+        } else _binUpdateHeight(curr);
+        curr = curr->_father;
+    }
+}
+
+/* Removes a node from the tree and rebalances it. If the node has two sons,
+ * its predecessor takes its place. The node keeps its contents and is left
+ * totally disconnected, ready to be freed.
+ */
+void _binDeleteNode(AVLBinTree *tree, AVLBinNode *node) {
+    AVLBinNode *remFather;  // Lowest node that lost a descendant.
+    if ((node->_leftSon == NULL) || (node->_rightSon == NULL)) {
+        // Let the only son, if any, take the place of the node.
+        remFather = node->_father;
+        _binReplaceSubtree(tree, node, (node->_leftSon != NULL) ?
+                                       _binCutLeftSubtree(node) :
+                                       _binCutRightSubtree(node));
+    } else {
+        // Detach the predecessor, then let it take the place of the node.
+        AVLBinNode *maxLeft = _binMaxKeySon(node->_leftSon);
+        remFather = maxLeft->_father;
+        if (remFather == node) {
+            remFather = maxLeft;
+            _binCutLeftSubtree(node);
+        } else {
+            _binReplaceSubtree(tree, maxLeft, _binCutLeftSubtree(maxLeft));
+            _binInsertAsLeftSubtree(maxLeft, _binCutLeftSubtree(node));
+        }
+        _binInsertAsRightSubtree(maxLeft, _binCutRightSubtree(node));
+        _binReplaceSubtree(tree, node, maxLeft);
+    }
+    _binBalanceDelete(tree, remFather);
+}
+
+/* Performs an in-order, recursive DFS. */
+void _binInODFS(AVLBinNode *rootNode, void ***intPtr, int intOpt) {
+    // Recursion base step.
+    if (rootNode == NULL) {
+        *(intPtr) = *(intPtr) - 1;
+        return;
+    }
+    // Recursive step: visit the left son.
+    _binInODFS(rootNode->_leftSon, intPtr, intOpt);
+    *(intPtr) = *(intPtr) + 1;
+    // Now visit the root node.
+    if (intOpt & SEARCH_NODES) {
+        **(intPtr) = rootNode;
+    } else if (intOpt & SEARCH_KEYS) {
+        **(intPtr) = &(rootNode->_key);
+    } else if (intOpt & SEARCH_DATA) {
+        **(intPtr) = rootNode->_data;
+    }
+    *(intPtr) = *(intPtr) + 1;
+    // Visit the right son and return.
+    _binInODFS(rootNode->_rightSon, intPtr, intOpt);
+}
+
+/* Performs a pre-order, recursive DFS. */
+void _binPreODFS(AVLBinNode *rootNode, void ***intPtr, int intOpt) {
+    // Recursion base step.
+    if (rootNode == NULL) {
+        *(intPtr) = *(intPtr) - 1;
+        return;
+    }
+    // Recursive step.
+    // Visit the root node.
+    if (intOpt & SEARCH_NODES) {
+        **(intPtr) = rootNode;
+    } else if (intOpt & SEARCH_KEYS) {
+        **(intPtr) = &(rootNode->_key);
+    } else if (intOpt & SEARCH_DATA) {
+        **(intPtr) = rootNode->_data;
+    }
+    *(intPtr) = *(intPtr) + 1;
+    // Now visit the left son.
+    _binPreODFS(rootNode->_leftSon, intPtr, intOpt);
+    *(intPtr) = *(intPtr) + 1;
+    // Visit the right son and return.
+    _binPreODFS(rootNode->_rightSon, intPtr, intOpt);
+}
+
+/* Performs a post-order, recursive DFS. */
+void _binPostODFS(AVLBinNode *rootNode, void ***intPtr, int intOpt) {
+    // Recursion base step.
+    if (rootNode == NULL) {
+        *(intPtr) = *(intPtr) - 1;
+        return;
+    }
+    // Recursive step.
+    // Visit the left son.
+    _binPostODFS(rootNode->_leftSon, intPtr, intOpt);
+    *(intPtr) = *(intPtr) + 1;
+    // Visit the right son.
+    _binPostODFS(rootNode->_rightSon, intPtr, intOpt);
+    *(intPtr) = *(intPtr) + 1;
+    // Visit the root node and return.
+    if (intOpt & SEARCH_NODES) {
+        **(intPtr) = rootNode;
+    } else if (intOpt & SEARCH_KEYS) {
+        **(intPtr) = &(rootNode->_key);
+    } else if (intOpt & SEARCH_DATA) {
+        **(intPtr) = rootNode->_data;
+    }
+}
@@ -0,0 +1,125 @@
+/* AVL Trees library contributors
+ * Creation Date: 17/10/2026
+ * Latest Version: 17/10/2026
+ * ----------------------------------------------------------------------------
+ * This is the source file for the memory budgets of the AVL Trees library.
+ * Trees charge to their budget the memory they allocate for themselves, and
+ * release it when they free it. Charges that would exceed the limit give the
+ * pressure callback a chance to free some memory, and are refused otherwise.
+ * Counters are updated atomically, with no locks.
+ * See the comments above each function definition for information about what
+ * each one does.
+ */
+/* This code is released under the MIT license.
+ * See the attached LICENSE file.
+ */
+
+#include <stdlib.h>
+#include "AVLTree_MemBudget.h"
+
+/* Internal library subroutines declarations. */
+int _memBudgetReserve(AVLMemBudget *budget, unsigned long int bytes);
+void _memBudgetPeak(AVLMemBudget *budget, unsigned long int used);
+
+// USER FUNCTIONS //
+/* Creates a new budget of the given number of bytes, with an optional
+ * pressure callback and its context.
+ * Returns NULL if it could not be allocated.
+ */
+AVLMemBudget *createMemBudget(unsigned long int limit,
+                              void (*pressure)(AVLMemBudget *budget,
+                                               unsigned long int bytes,
+                                               void *ctx),
+                              void *ctx) {
+    AVLMemBudget *newBudget = (AVLMemBudget *) malloc(sizeof(AVLMemBudget));
+    if (newBudget == NULL) return NULL;
+    newBudget->limit = limit;
+    newBudget->used = 0;
+    newBudget->peak = 0;
+    newBudget->refusals = 0;
+    newBudget->_pressure = pressure;
+    newBudget->_ctx = ctx;
+    newBudget->_relieving = 0;
+    return newBudget;
+}
+
+/* Frees a budget from the heap. No tree must be using it anymore. */
+int deleteMemBudget(AVLMemBudget *budget) {
+    if (budget == NULL) return -1;  // Sanity check.
+    free(budget);
+    return 0;
+}
+
+/* Charges the given number of bytes to the budget, if they fit in it, calling
+ * the pressure callback and trying again if they don't.
+ * Returns 0 if successful, -1 if the bytes were refused.
+ */
+int memBudgetCharge(AVLMemBudget *budget, unsigned long int bytes) {
+    if (budget == NULL) return 0;  // Sanity check.
+    if (_memBudgetReserve(budget, bytes) == 0) return 0;
+    // Only one thread at a time tries to relieve the pressure.
+    if ((budget->_pressure != NULL) &&
+        (__atomic_exchange_n(&(budget->_relieving), 1,
+                             __ATOMIC_ACQUIRE) == 0)) {
+        budget->_pressure(budget, bytes, budget->_ctx);
+        __atomic_store_n(&(budget->_relieving), 0, __ATOMIC_RELEASE);
+        if (_memBudgetReserve(budget, bytes) == 0) return 0;
+    }
+    __atomic_add_fetch(&(budget->refusals), 1, __ATOMIC_RELAXED);
+    return -1;
+}
+
+/* Charges the given number of bytes to the budget only if they fit in it,
+ * without calling the pressure callback: meant for memory needed while a tree
+ * is being visited or modified, which the callback must not change under it.
+ * Returns 0 if successful, -1 if the bytes were refused.
+ */
+int memBudgetTryCharge(AVLMemBudget *budget, unsigned long int bytes) {
+    if (budget == NULL) return 0;  // Sanity check.
+    if (_memBudgetReserve(budget, bytes) == 0) return 0;
+    __atomic_add_fetch(&(budget->refusals), 1, __ATOMIC_RELAXED);
+    return -1;
+}
+
+/* Charges the given number of bytes to the budget even if they exceed it:
+ * meant for memory that can't be done without, like the one needed to keep a
+ * tree consistent while it's being modified, or to complete a visit.
+ */
+void memBudgetForce(AVLMemBudget *budget, unsigned long int bytes) {
+    if (budget == NULL) return;  // Sanity check.
+    _memBudgetPeak(budget, __atomic_add_fetch(&(budget->used), bytes,
+                                              __ATOMIC_RELAXED));
+}
+
+/* Gives back to the budget the given number of bytes, previously charged. */
+void memBudgetRelease(AVLMemBudget *budget, unsigned long int bytes) {
+    if (budget == NULL) return;  // Sanity check.
+    __atomic_sub_fetch(&(budget->used), bytes, __ATOMIC_RELAXED);
+}
+
+// INTERNAL LIBRARY SUBROUTINES //
+/* Adds the given number of bytes to those used, if they fit in the limit.
+ * Returns 0 if successful, -1 if they don't fit.
+ */
+int _memBudgetReserve(AVLMemBudget *budget, unsigned long int bytes) {
+    unsigned long int used = __atomic_load_n(&(budget->used),
+                                             __ATOMIC_RELAXED);
+    unsigned long int limit;
+    do {
+        limit = __atomic_load_n(&(budget->limit), __ATOMIC_RELAXED);
+        if ((used > limit) || (bytes > limit - used)) return -1;
+    } while (!__atomic_compare_exchange_n(&(budget->used), &used,
+                                          used + bytes, 1, __ATOMIC_RELAXED,
+                                          __ATOMIC_RELAXED));
+    _memBudgetPeak(budget, used + bytes);
+    return 0;
+}
+
+/* Updates the peak usage of the budget, given the current one. */
+void _memBudgetPeak(AVLMemBudget *budget, unsigned long int used) {
+    unsigned long int peak = __atomic_load_n(&(budget->peak),
+                                             __ATOMIC_RELAXED);
+    while ((used > peak) &&
+           !__atomic_compare_exchange_n(&(budget->peak), &peak, used, 1,
+                                        __ATOMIC_RELAXED, __ATOMIC_RELAXED));
+}
@@ -0,0 +1,54 @@
+/* AVL Trees library contributors
+ * Creation Date: 17/10/2026
+ * Latest Version: 17/10/2026
+ * ----------------------------------------------------------------------------
+ * This file contains type definitions and declarations for the memory budgets
+ * that can be shared by trees of all the AVL Trees flavours. See the source
+ * file for brief descriptions of what each function does.
+ * Note that functions which names start with "_" are meant for internal use
+ * only, and only those without it should be used by the actual programmer.
+ */
+/* This code is released under the MIT license.
+ * See the attached LICENSE file.
+ */
+
+#ifndef AVLTREES_MEMBUDGET_H
+#define AVLTREES_MEMBUDGET_H
+
+/* A budget caps the number of bytes that the trees charged to it can use
+ * altogether, and keeps track of how many they are using, and of the most
+ * they have ever used.
+ * When a tree needs more memory than what is left, the pressure callback, if
+ * any, is called with the number of bytes needed and the given context, so
+ * that it can free some (e.g. by deleting entries from the trees): the tree
+ * then tries again, and refuses to grow if there's still not enough room.
+ * Only one thread at a time runs the callback: other threads that run out of
+ * room in the meantime are refused right away, and so are the trees the
+ * callback itself tries to grow.
+ * Budgets can be shared by trees used by different threads. The limit can be
+ * changed at will.
+ */
+typedef struct _avlMemBudget {
+    unsigned long int limit;
+    unsigned long int used;
+    unsigned long int peak;
+    unsigned long int refusals;
+    void (*_pressure)(struct _avlMemBudget *budget, unsigned long int bytes,
+                      void *ctx);
+    void *_ctx;
+    int _relieving;
+} AVLMemBudget;
+
+/* Library functions. */
+AVLMemBudget *createMemBudget(unsigned long int limit,
+                              void (*pressure)(AVLMemBudget *budget,
+                                               unsigned long int bytes,
+                                               void *ctx),
+                              void *ctx);
+int deleteMemBudget(AVLMemBudget *budget);
+int memBudgetCharge(AVLMemBudget *budget, unsigned long int bytes);
+int memBudgetTryCharge(AVLMemBudget *budget, unsigned long int bytes);
+void memBudgetForce(AVLMemBudget *budget, unsigned long int bytes);
+void memBudgetRelease(AVLMemBudget *budget, unsigned long int bytes);
+
+#endif
@@ -0,0 +1,366 @@
+/* AVL Trees library contributors
+ * Creation Date: 17/10/2026
+ * Latest Version: 17/10/2026
+ * ----------------------------------------------------------------------------
+ * This is the source file for the work-stealing thread pool used by the
+ * parallel operations of the AVL Trees library.
+ * Algorithms use it in fork/join style: a task spawns subtasks for parts of
+ * its work, does the rest, then syncs with them. Spawned tasks wait in the
+ * spawner's deque, from which idle workers steal them; a worker waiting for a
+ * stolen task helps by running other tasks in the meantime.
+ * See the comments above each function definition for information about what
+ * each one does.
+ */
+/* This code is released under the MIT license.
+ * See the attached LICENSE file.
+ */
+
+#include <stdlib.h>
+#include <sched.h>
+#include <pthread.h>
+#include "AVLTree_WorkPool.h"
+
+/* Number of times an idle worker looks for tasks before going to sleep. */
+#define WORKPOOL_SPINS 64
+
+/* A range of indexes for which a routine must be called, as split among
+ * tasks by workPoolFor.
+ */
+typedef struct {
+    void (*_routine)(void *, unsigned long int);
+    void *_arg;
+    unsigned long int _lo;
+    unsigned long int _hi;
+} AVLWorkRange;
+
+/* The worker the current thread is, or NULL if it's not a worker. */
+__thread AVLWorkWorker *_workPoolSelf = NULL;
+
+/* The pool whose tasks the current thread is running, or NULL if the routine
+ * it's running was given to workPoolRun with no pool, in which case what it
+ * spawns must not end up in a deque.
+ */
+__thread AVLWorkPool *_workPoolActive = NULL;
+
+/* Internal library subroutines declarations. */
+int _workDequePush(AVLWorkDeque *deque, AVLWorkTask *task);
+AVLWorkTask *_workDequePop(AVLWorkDeque *deque);
+AVLWorkTask *_workDequeSteal(AVLWorkDeque *deque);
+AVLWorkTask *_workPoolSteal(AVLWorkWorker *self);
+AVLWorkTask *_workPoolTakeRoot(AVLWorkPool *pool);
+int _workPoolHasWork(AVLWorkPool *pool);
+void _workPoolExecute(AVLWorkPool *pool, AVLWorkTask *task);
+void _workPoolNotify(AVLWorkPool *pool);
+void *_workPoolWorker(void *arg);
+void _workPoolForRange(void *arg);
+
+// USER FUNCTIONS //
+/* Creates a new pool with the specified number of worker threads.
+ * Returns NULL if something could not be allocated or started.
+ */
+AVLWorkPool *createWorkPool(int nthreads) {
+    if (nthreads < 1) return NULL;  // Sanity check.
+    AVLWorkPool *newPool = (AVLWorkPool *) malloc(sizeof(AVLWorkPool));
+    if (newPool == NULL) return NULL;
+    newPool->_workers = (AVLWorkWorker *) calloc(nthreads,
+                                                 sizeof(AVLWorkWorker));
+    if (newPool->_workers == NULL) {
+        free(newPool);
+        return NULL;
+    }
+    newPool->_roots = NULL;
+    newPool->_sleeping = 0;
+    newPool->_stop = 0;
+    newPool->nthreads = nthreads;
+    newPool->grain = WORKPOOL_DEFAULT_GRAIN;
+    pthread_mutex_init(&(newPool->_lock), NULL);
+    pthread_cond_init(&(newPool->_wakeUp), NULL);
+    pthread_cond_init(&(newPool->_rootDone), NULL);
+    for (int i = 0; i < nthreads; i++) {
+        newPool->_workers[i]._pool = newPool;
+        newPool->_workers[i]._id = i;
+        newPool->_workers[i]._seed = (unsigned int) i + 1;
+        newPool->_workers[i]._deque._top = 0;
+        newPool->_workers[i]._deque._bottom = 0;
+        pthread_mutex_init(&(newPool->_workers[i]._deque._lock), NULL);
+    }
+    // Start the workers, and if one can't be started stop the others.
+    for (int i = 0; i < nthreads; i++) {
+        if (pthread_create(&(newPool->_workers[i]._thread), NULL,
+                           _workPoolWorker, &(newPool->_workers[i])) != 0) {
+            newPool->nthreads = i;
+            deleteWorkPool(newPool);
+            return NULL;
+        }
+    }
+    return newPool;
+}
+
+/* Stops the workers of a pool and frees it from the heap.
+ * No tasks must be running when this is called.
+ */
+int deleteWorkPool(AVLWorkPool *pool) {
+    if (pool == NULL) return -1;  // Sanity check.
+    pthread_mutex_lock(&(pool->_lock));
+    __atomic_store_n(&(pool->_stop), 1, __ATOMIC_RELAXED);
+    pthread_cond_broadcast(&(pool->_wakeUp));
+    pthread_mutex_unlock(&(pool->_lock));
+    for (int i = 0; i < pool->nthreads; i++)
+        pthread_join(pool->_workers[i]._thread, NULL);
+    for (int i = 0; i < pool->nthreads; i++)
+        pthread_mutex_destroy(&(pool->_workers[i]._deque._lock));
+    pthread_mutex_destroy(&(pool->_lock));
+    pthread_cond_destroy(&(pool->_wakeUp));
+    pthread_cond_destroy(&(pool->_rootDone));
+    free(pool->_workers);
+    free(pool);
+    return 0;
+}
+
+/* Runs a routine as a task of the pool, and waits for it to complete.
+ * The routine can spawn and sync other tasks. If called from one of the
+ * pool's workers, the routine is just called, and the tasks it spawns go to
+ * that worker's deque as usual. If the pool is NULL, the routine is just
+ * called too, and all the tasks it spawns are run sequentially, even on a
+ * worker of another pool.
+ * Returns 0 if successful, -1 otherwise.
+ */
+int workPoolRun(AVLWorkPool *pool, void (*routine)(void *), void *arg) {
+    if (routine == NULL) return -1;  // Sanity check.
+    if ((pool == NULL) ||
+        ((_workPoolSelf != NULL) && (_workPoolSelf->_pool == pool))) {
+        AVLWorkPool *active = _workPoolActive;
+        _workPoolActive = pool;
+        routine(arg);
+        _workPoolActive = active;
+        return 0;
+    }
+    AVLWorkTask root = {routine, arg, 0, 1, NULL};
+    // Queue the task and wait for a worker to complete it.
+    pthread_mutex_lock(&(pool->_lock));
+    root._next = pool->_roots;
+    __atomic_store_n(&(pool->_roots), &root, __ATOMIC_RELAXED);
+    pthread_cond_signal(&(pool->_wakeUp));
+    while (!root._done) pthread_cond_wait(&(pool->_rootDone), &(pool->_lock));
+    pthread_mutex_unlock(&(pool->_lock));
+    return 0;
+}
+
+/* Spawns a task, which may then be run by any worker of the pool the caller
+ * belongs to. The task must be synced before it goes out of scope.
+ * If the caller is not a worker, is not running tasks of its own pool (see
+ * workPoolRun), or its deque is full, the routine is just called.
+ */
+void workPoolSpawn(AVLWorkTask *task, void (*routine)(void *), void *arg) {
+    AVLWorkWorker *self = _workPoolSelf;
+    task->_routine = routine;
+    task->_arg = arg;
+    task->_done = 0;
+    task->_root = 0;
+    task->_next = NULL;
+    if ((self == NULL) || (self->_pool != _workPoolActive) ||
+        !_workDequePush(&(self->_deque), task)) {
+        routine(arg);
+        task->_done = 1;
+        return;
+    }
+    _workPoolNotify(self->_pool);
+}
+
+/* Waits for a spawned task to complete. If it is still in the caller's deque,
+ * it is run by the caller; otherwise, other tasks are run while waiting.
+ */
+void workPoolSync(AVLWorkTask *task) {
+    AVLWorkWorker *self = _workPoolSelf;
+    AVLWorkTask *other;
+    while (!__atomic_load_n(&(task->_done), __ATOMIC_ACQUIRE)) {
+        other = NULL;
+        if (self != NULL) {
+            other = _workDequePop(&(self->_deque));
+            if (other == NULL) other = _workPoolSteal(self);
+        }
+        if (other != NULL) {
+            _workPoolExecute(self->_pool, other);
+        } else sched_yield();
+    }
+}
+
+/* Calls a routine with each index from zero to n (excluded) as a task of the
+ * pool, splitting the range recursively, and waits for all calls to return.
+ * As with workPoolRun, a NULL pool runs everything sequentially.
+ */
+void workPoolFor(AVLWorkPool *pool, void (*routine)(void *, unsigned long int),
+                 void *arg, unsigned long int n) {
+    if ((routine == NULL) || (n == 0)) return;  // Sanity check.
+    AVLWorkRange range = {routine, arg, 0, n};
+    workPoolRun(pool, _workPoolForRange, &range);
+}
+
+// INTERNAL LIBRARY SUBROUTINES //
+/* Pushes a task at the bottom of a deque. Returns 0 if the deque is full. */
+int _workDequePush(AVLWorkDeque *deque, AVLWorkTask *task) {
+    int res = 0;
+    pthread_mutex_lock(&(deque->_lock));
+    if (deque->_bottom - deque->_top < WORKPOOL_DEQUE_SIZE) {
+        deque->_tasks[deque->_bottom % WORKPOOL_DEQUE_SIZE] = task;
+        __atomic_store_n(&(deque->_bottom), deque->_bottom + 1,
+                         __ATOMIC_RELAXED);
+        res = 1;
+    }
+    pthread_mutex_unlock(&(deque->_lock));
+    return res;
+}
+
+/* Pops the task at the bottom of a deque, or returns NULL if it's empty. */
+AVLWorkTask *_workDequePop(AVLWorkDeque *deque) {
+    AVLWorkTask *task = NULL;
+    if (__atomic_load_n(&(deque->_bottom), __ATOMIC_RELAXED) ==
+        __atomic_load_n(&(deque->_top), __ATOMIC_RELAXED)) return NULL;
+    pthread_mutex_lock(&(deque->_lock));
+    if (deque->_bottom != deque->_top) {
+        __atomic_store_n(&(deque->_bottom), deque->_bottom - 1,
+                         __ATOMIC_RELAXED);
+        task = deque->_tasks[deque->_bottom % WORKPOOL_DEQUE_SIZE];
+    }
+    pthread_mutex_unlock(&(deque->_lock));
+    return task;
+}
+
+/* Steals the task at the top of a deque, or returns NULL if it's empty. */
+AVLWorkTask *_workDequeSteal(AVLWorkDeque *deque) {
+    AVLWorkTask *task = NULL;
+    if (__atomic_load_n(&(deque->_bottom), __ATOMIC_RELAXED) ==
+        __atomic_load_n(&(deque->_top), __ATOMIC_RELAXED)) return NULL;
+    pthread_mutex_lock(&(deque->_lock));
+    if (deque->_bottom != deque->_top) {
+        task = deque->_tasks[deque->_top % WORKPOOL_DEQUE_SIZE];
+        __atomic_store_n(&(deque->_top), deque->_top + 1, __ATOMIC_RELAXED);
+    }
+    pthread_mutex_unlock(&(deque->_lock));
+    return task;
+}
+
+/* Tries to steal a task from the other workers, starting from a random one. */
+AVLWorkTask *_workPoolSteal(AVLWorkWorker *self) {
+    AVLWorkPool *pool = self->_pool;
+    AVLWorkTask *task;
+    int victim = rand_r(&(self->_seed)) % pool->nthreads;
+    for (int i = 0; i < pool->nthreads; i++) {
+        if (victim != self->_id) {
+            task = _workDequeSteal(&(pool->_workers[victim]._deque));
+            if (task != NULL) return task;
+        }
+        victim = (victim + 1) % pool->nthreads;
+    }
+    return NULL;
+}
+
+/* Takes one of the tasks submitted from outside the pool, if there are any. */
+AVLWorkTask *_workPoolTakeRoot(AVLWorkPool *pool) {
+    AVLWorkTask *task;
+    if (__atomic_load_n(&(pool->_roots), __ATOMIC_RELAXED) == NULL)
+        return NULL;
+    pthread_mutex_lock(&(pool->_lock));
+    task = pool->_roots;
+    if (task != NULL)
+        __atomic_store_n(&(pool->_roots), task->_next, __ATOMIC_RELAXED);
+    pthread_mutex_unlock(&(pool->_lock));
+    return task;
+}
+
+/* Tells whether there are tasks waiting in any deque, or submitted from
+ * outside the pool.
+ */
+int _workPoolHasWork(AVLWorkPool *pool) {
+    AVLWorkDeque *deque;
+    if (__atomic_load_n(&(pool->_roots), __ATOMIC_RELAXED) != NULL) return 1;
+    for (int i = 0; i < pool->nthreads; i++) {
+        deque = &(pool->_workers[i]._deque);
+        if (__atomic_load_n(&(deque->_bottom), __ATOMIC_RELAXED) !=
+            __atomic_load_n(&(deque->_top), __ATOMIC_RELAXED)) return 1;
+    }
+    return 0;
+}
+
+/* Runs a task and marks it as completed, waking its submitter if it came from
+ * outside the pool. The task must not be touched afterwards, since whoever
+ * waits for it may let it go out of scope.
+ */
+void _workPoolExecute(AVLWorkPool *pool, AVLWorkTask *task) {
+    task->_routine(task->_arg);
+    if (task->_root) {
+        pthread_mutex_lock(&(pool->_lock));
+        task->_done = 1;
+        pthread_cond_broadcast(&(pool->_rootDone));
+        pthread_mutex_unlock(&(pool->_lock));
+    } else __atomic_store_n(&(task->_done), 1, __ATOMIC_RELEASE);
+}
+
+/* Wakes up a sleeping worker, if there is one, to steal a new task.
+ * Workers count themselves as sleeping before they look for tasks one last
+ * time, and the task was pushed before they are counted here, so either they
+ * find it or they get woken up.
+ */
+void _workPoolNotify(AVLWorkPool *pool) {
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    if (__atomic_load_n(&(pool->_sleeping), __ATOMIC_RELAXED) == 0) return;
+    pthread_mutex_lock(&(pool->_lock));
+    pthread_cond_signal(&(pool->_wakeUp));
+    pthread_mutex_unlock(&(pool->_lock));
+}
+
+/* Body of a worker thread: looks for tasks in its deque, then in the others'
+ * and among the submitted ones, and sleeps until woken up when there are
+ * none.
+ */
+void *_workPoolWorker(void *arg) {
+    AVLWorkWorker *self = (AVLWorkWorker *) arg;
+    AVLWorkPool *pool = self->_pool;
+    AVLWorkTask *task;
+    int idle = 0;
+    _workPoolSelf = self;
+    _workPoolActive = pool;
+    while (!__atomic_load_n(&(pool->_stop), __ATOMIC_RELAXED)) {
+        task = _workDequePop(&(self->_deque));
+        if (task == NULL) task = _workPoolSteal(self);
+        if (task == NULL) task = _workPoolTakeRoot(pool);
+        if (task != NULL) {
+            _workPoolExecute(pool, task);
+            idle = 0;
+            continue;
+        }
+        if (++idle < WORKPOOL_SPINS) {
+            sched_yield();
+            continue;
+        }
+        // Nothing to do for a while: sleep until a task is spawned or
+        // submitted, or the pool is deleted.
+        pthread_mutex_lock(&(pool->_lock));
+        __atomic_add_fetch(&(pool->_sleeping), 1, __ATOMIC_RELAXED);
+        __atomic_thread_fence(__ATOMIC_SEQ_CST);
+        if (!pool->_stop && !_workPoolHasWork(pool))
+            pthread_cond_wait(&(pool->_wakeUp), &(pool->_lock));
+        __atomic_sub_fetch(&(pool->_sleeping), 1, __ATOMIC_RELAXED);
+        pthread_mutex_unlock(&(pool->_lock));
+        idle = 0;
+    }
+    return NULL;
+}
+
+/* Calls the routine on a range of indexes, spawning a task for one half of it
+ * and keeping the other until only one index is left.
+ */
+void _workPoolForRange(void *arg) {
+    AVLWorkRange *range = (AVLWorkRange *) arg;
+    if (range->_hi - range->_lo <= 1) {
+        if (range->_hi > range->_lo) range->_routine(range->_arg, range->_lo);
+        return;
+    }
+    unsigned long int mid = range->_lo + (range->_hi - range->_lo) / 2;
+    AVLWorkRange left = {range->_routine, range->_arg, range->_lo, mid};
+    AVLWorkRange right = {range->_routine, range->_arg, mid, range->_hi};
+    AVLWorkTask task;
+    workPoolSpawn(&task, _workPoolForRange, &left);
+    _workPoolForRange(&right);
+    workPoolSync(&task);
+}
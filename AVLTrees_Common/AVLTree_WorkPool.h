@@ -0,0 +1,91 @@
+/* AVL Trees library contributors
+ * Creation Date: 17/10/2026
+ * Latest Version: 17/10/2026
+ * ----------------------------------------------------------------------------
+ * This file contains type definitions and declarations for the work-stealing
+ * thread pool shared by the parallel operations of all the AVL Trees flavours.
+ * See the source file for brief descriptions of what each function does.
+ * Note that functions which names start with "_" are meant for internal use
+ * only, and only those without it should be used by the actual programmer.
+ */
+/* This code is released under the MIT license.
+ * See the attached LICENSE file.
+ */
+
+#ifndef AVLTREES_WORKPOOL_H
+#define AVLTREES_WORKPOOL_H
+
+#include <pthread.h>
+
+/* Default minimum amount of work (e.g. nodes in a subtree) that is worth a
+ * new task: anything smaller is done sequentially by whoever finds it.
+ */
+#define WORKPOOL_DEFAULT_GRAIN 2048
+
+/* Maximum number of tasks that can wait in each worker's deque. Tasks spawned
+ * while the deque is full are just run on the spot.
+ */
+#define WORKPOOL_DEQUE_SIZE 256
+
+/* A task stores the routine to run and its argument, and tells when it has
+ * been completed. Tasks are allocated by the caller, usually on the stack of
+ * the function that spawns and then syncs them, so spawning needs no heap.
+ */
+typedef struct _avlWorkTask {
+    void (*_routine)(void *);
+    void *_arg;
+    int _done;
+    int _root;
+    struct _avlWorkTask *_next;
+} AVLWorkTask;
+
+/* Each worker owns a deque of tasks: it pushes and pops them at the bottom,
+ * while idle workers steal them from the top, so that thieves get the oldest
+ * tasks, which in divide-and-conquer algorithms are also the biggest ones.
+ */
+typedef struct {
+    pthread_mutex_t _lock;
+    AVLWorkTask *_tasks[WORKPOOL_DEQUE_SIZE];
+    unsigned long int _top;
+    unsigned long int _bottom;
+} AVLWorkDeque;
+
+struct _avlWorkPool;
+
+/* A worker thread knows its pool and its deque, and keeps the state of the
+ * generator used to choose the victims of its thefts.
+ */
+typedef struct {
+    struct _avlWorkPool *_pool;
+    pthread_t _thread;
+    AVLWorkDeque _deque;
+    unsigned int _seed;
+    int _id;
+} AVLWorkWorker;
+
+/* A pool stores its workers and the tasks submitted from outside it, and the
+ * means to let idle workers sleep. The grain is the cutoff below which the
+ * parallel tree operations stop spawning tasks, and can be changed at will.
+ */
+typedef struct _avlWorkPool {
+    AVLWorkWorker *_workers;
+    AVLWorkTask *_roots;
+    pthread_mutex_t _lock;
+    pthread_cond_t _wakeUp;
+    pthread_cond_t _rootDone;
+    int _sleeping;
+    int _stop;
+    int nthreads;
+    unsigned long int grain;
+} AVLWorkPool;
+
+/* Library functions. */
+AVLWorkPool *createWorkPool(int nthreads);
+int deleteWorkPool(AVLWorkPool *pool);
+int workPoolRun(AVLWorkPool *pool, void (*routine)(void *), void *arg);
+void workPoolSpawn(AVLWorkTask *task, void (*routine)(void *), void *arg);
+void workPoolSync(AVLWorkTask *task);
+void workPoolFor(AVLWorkPool *pool, void (*routine)(void *, unsigned long int),
+                 void *arg, unsigned long int n);
+
+#endif
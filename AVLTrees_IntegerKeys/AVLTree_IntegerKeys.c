@@ -1,6 +1,6 @@
 /* Roberto Masocco
  * Creation Date: 26/7/2019
- * Latest Version: 26/7/2019
+ * Latest Version: 17/10/2026
  * ----------------------------------------------------------------------------
  * This is the main source file for the AVL Trees library.
  * See the comments above each function definition for information about what
@@ -12,36 +12,219 @@
  */
 
 #include <stdlib.h>
+#include <stddef.h>
+#include <string.h>
 #include <limits.h>
 #include "AVLTree_IntegerKeys.h"
 
 /* Macro to find the maximum between two integers. */
 #define MAX(X, Y) ((X) <= (Y) ? (Y) : (X))
 
+/* Maximum fraction of the slots of a hash index that can be used before it
+ * grows, as a power of two (e.g. 1 means half of them).
+ */
+#define INDEX_LOAD_SHIFT 1
+
+/* Macro to get the address of the summary that augments a node, which
+ * follows it in memory.
+ */
+#define AUGMENT(NODE) ((void *) ((NODE) + 1))
+
+/* Macro to get the number of bytes taken by an entry of a tree: that of its
+ * node, summary included.
+ */
+#define ENTRY_BYTES(TREE) (sizeof(AVLIntNode) + (TREE)->_augment.augSize)
+
+/* Macro to compare two integers without risking the overflows that a
+ * subtraction would cause: evaluates to 1, 0 or -1.
+ */
+#define COMPARE(X, Y) (((X) > (Y)) - ((X) < (Y)))
+
+/* Number of subtrees handed to each worker in parallel breadth-first visits:
+ * more than one lets workers that got smaller subtrees pick up some more work.
+ */
+#define PAR_TASKS_PER_THREAD 8
+
+/* Number of bits of the keys sorted by each pass of the radix sort. */
+#define RADIX_BITS 8
+#define RADIX_BUCKETS (1 << RADIX_BITS)
+
+/* Macro to extract the digit of a key examined by a pass of the radix sort.
+ * The sign bit is flipped so that negative keys come first.
+ */
+#define RADIX_DIGIT(KEY, SHIFT) \
+    ((((unsigned int) (KEY) ^ (1U << (sizeof(int) * CHAR_BIT - 1))) >> \
+      (SHIFT)) & (RADIX_BUCKETS - 1))
+
+/* Shared state of a parallel visit: the result array, the kind of visit and
+ * the size above which a subtree is worth a new task.
+ * Breadth-first visits also need the subtrees found at a cut depth, each
+ * visited by a task, and a matrix of offsets with a row for the top of the
+ * tree plus one for each subtree, and a column for each level, which are used
+ * first as counters and then as write cursors.
+ */
+typedef struct {
+    void *_res;
+    int _type;
+    int _intOpt;
+    unsigned long int _grain;
+    int _cutDepth;
+    int _levels;
+    int _store;
+    AVLIntNode **_roots;
+    unsigned long int *_offsets;
+    unsigned long int _nTasks;
+} AVLIntParVisit;
+
+/* A step of a parallel depth-first visit: a subtree, and the position of its
+ * first entry in the result.
+ */
+typedef struct {
+    AVLIntParVisit *_visit;
+    AVLIntNode *_node;
+    unsigned long int _offset;
+} AVLIntParStep;
+
+/* A key and its data, as sorted while building a tree. */
+typedef struct {
+    int _key;
+    void *_data;
+} AVLIntPair;
+
+/* Shared state of a parallel build: the input, the entries as they are being
+ * sorted, the per-chunk digit counters of the radix sort (a row of
+ * RADIX_BUCKETS counters for each chunk of the input), and the size above
+ * which a subtree is worth a new task.
+ */
+typedef struct {
+    int *_keys;
+    void **_data;
+    AVLIntPair *_pairs;
+    AVLIntPair *_tmp;
+    unsigned long int _n;
+    unsigned long int _nChunks;
+    unsigned long int *_counts;
+    int _shift;
+    int _failed;
+    unsigned long int _grain;
+} AVLIntParBuild;
+
+/* A subtree to be built from a range of the sorted entries, and the place in
+ * which it has to be attached.
+ */
+typedef struct {
+    AVLIntParBuild *_build;
+    AVLIntNode *_father;
+    AVLIntNode **_slot;
+    unsigned long int _lo;
+    unsigned long int _hi;
+} AVLIntBuildStep;
+
+/* Shared state of a parallel fold of the tree's entries, either to call a
+ * function on each of them or to reduce them to a single value, and the size
+ * above which a subtree is worth a new task.
+ */
+typedef struct {
+    void (*_forEach)(int key, void *data, void *ctx);
+    void *(*_reduce)(void *acc, int key, void *data, void *ctx);
+    void *(*_combine)(void *acc1, void *acc2, void *ctx);
+    void *_identity;
+    void *_ctx;
+    unsigned long int _grain;
+} AVLIntParFold;
+
+/* A step of a parallel fold: a subtree, and its partial result. */
+typedef struct {
+    AVLIntParFold *_fold;
+    AVLIntNode *_node;
+    void *_acc;
+} AVLIntFoldStep;
+
 /* Internal library subroutines declarations. */
-AVLIntNode *_createIntNode(int newKey, void *newData);
+AVLIntNode *_createIntNode(int newKey, void *newData,
+                           unsigned long int augSize);
 void _deleteIntNode(AVLIntNode *node);
 AVLIntNode *_searchIntNode(AVLIntTree *tree, int key);
+AVLIntNode *_intFingerStart(AVLIntNode *finger, int key);
+AVLIntNode *_intFingerSearch(AVLIntNode *finger, int key);
 void _intInsertAsLeftSubtree(AVLIntNode *father, AVLIntNode *newSon);
 void _intInsertAsRightSubtree(AVLIntNode *father, AVLIntNode *newSon);
 AVLIntNode *_intCutLeftSubtree(AVLIntNode *father);
 AVLIntNode *_intCutRightSubtree(AVLIntNode *father);
 AVLIntNode *_intCutSubtree(AVLIntNode *node);
 AVLIntNode *_intMaxKeySon(AVLIntNode *node);
-AVLIntNode *_intCutOneSonNode(AVLIntNode *node);
+AVLIntNode *_intPrevNode(AVLIntNode *node);
+void _intReplaceSubtree(AVLIntTree *tree, AVLIntNode *node,
+                        AVLIntNode *newNode);
+void _intDeleteNode(AVLIntTree *tree, AVLIntNode *node);
 int _intHeight(AVLIntNode *node);
+unsigned long int _intSize(AVLIntNode *node);
 void _intSetHeight(AVLIntNode *node, int newHeight);
-void _intSwapInfo(AVLIntNode *node1, AVLIntNode *node2);
 int _intBalanceFactor(AVLIntNode *node);
-void _intUpdateHeight(AVLIntNode *node);
-void _intRightRotation(AVLIntNode *node);
-void _intLeftRotation(AVLIntNode *node);
-void _intRotate(AVLIntNode *node);
-void _intBalanceInsert(AVLIntNode *newNode);
-void _intBalanceDelete(AVLIntNode *remFather);
+void _intUpdateHeight(AVLIntTree *tree, AVLIntNode *node);
+void _intUpdateAugment(AVLIntTree *tree, AVLIntNode *node);
+void _intRightRotation(AVLIntTree *tree, AVLIntNode *node);
+void _intLeftRotation(AVLIntTree *tree, AVLIntNode *node);
+AVLIntNode *_intRotate(AVLIntTree *tree, AVLIntNode *node);
+void _intBalanceInsert(AVLIntTree *tree, AVLIntNode *newNode);
+void _intBalanceDelete(AVLIntTree *tree, AVLIntNode *remFather);
+int _intEvict(AVLIntTree *tree);
+int _intCharge(AVLIntTree *tree, unsigned long int bytes, int quiet);
+void _intRelease(AVLIntTree *tree, unsigned long int bytes);
+void _intUseNode(AVLIntTree *tree, AVLIntNode *node);
+void _intForgetUse(AVLIntTree *tree, AVLIntNode *node);
+unsigned long int _intCacheSlot(AVLIntTree *tree, int key);
+void _intCacheForget(AVLIntTree *tree, AVLIntNode *node);
+unsigned long int _intIndexHome(int bits, int key);
+void _intIndexPut(AVLIntIndexSlot *index, int bits, AVLIntNode *node);
+void _intIndexFill(AVLIntIndexSlot *index, int bits, AVLIntNode *node);
+int _intIndexResize(AVLIntTree *tree, int bits, int quiet);
+int _intIndexReserve(AVLIntTree *tree, unsigned long int count);
+int _intIndexAdd(AVLIntTree *tree, AVLIntNode *node);
+void _intIndexRemove(AVLIntTree *tree, AVLIntNode *node);
+AVLIntNode *_intIndexLookup(AVLIntTree *tree, int key);
 void _intInODFS(AVLIntNode *rootNode, void ***intPtr, int intOpt);
 void _intPreODFS(AVLIntNode *rootNode, void ***intPtr, int intOpt);
 void _intPostODFS(AVLIntNode *rootNode, void ***intPtr, int intOpt);
+AVLIntNode *_intTreeInsert(AVLIntTree *tree, AVLIntNode *finger, int newKey,
+                           void *newData);
+unsigned long int _intRandomRank(unsigned short rng[3], unsigned long int n);
+AVLIntNode *_intSelectNode(AVLIntNode *node, unsigned long int rank);
+int _intCompareRanks(const void *rank1, const void *rank2);
+unsigned long int _intTakeExtremes(AVLIntTree *tree, unsigned long int k,
+                                   int *keys, void **data, int largest);
+int _intPopExtreme(AVLIntTree *tree, int *key, void **data, int largest);
+unsigned long int _intBufferSearch(AVLIntTree *tree, int key);
+void _intBufferInsert(AVLIntTree *tree, int newKey, void *newData);
+void _intBufferRemove(AVLIntTree *tree, unsigned long int pos,
+                      unsigned long int count);
+void _intFreeBuffer(AVLIntTree *tree, int opts);
+AVLIntNode *_intTraverseFirst(AVLIntNode *root, int type);
+AVLIntNode *_intTraverseNext(AVLIntNode *root, AVLIntNode *node, int type,
+                             int *depth);
+AVLIntNode *_intLevelFirst(AVLIntNode *node, int depth, int leftFirst);
+AVLIntNode *_intLevelNext(AVLIntNode *node, int leftFirst);
+int _intGrowFrontier(AVLIntTree *tree, AVLIntNode ***frontier,
+                     unsigned long int *capacity, unsigned long int needed);
+void *_intAllocVisit(unsigned long int count, int opts, int *intOpt);
+void _intStoreEntry(void *res, unsigned long int pos, AVLIntNode *node,
+                    int intOpt);
+int _intCutDepth(int height, int nthreads);
+void _intDFSAt(AVLIntParVisit *visit, AVLIntNode *node,
+               unsigned long int offset);
+void _intParDFS(void *arg);
+void _intLevelVisit(AVLIntParVisit *visit, AVLIntNode *node, int depth,
+                    unsigned long int row);
+void _intParBFSSplit(AVLIntParVisit *visit, AVLIntNode *node, int depth);
+void _intParBFSTask(void *arg, unsigned long int task);
+void _intParLoadTask(void *arg, unsigned long int chunk);
+void _intParCountTask(void *arg, unsigned long int chunk);
+void _intParScatterTask(void *arg, unsigned long int chunk);
+int _intBuildHeight(unsigned long int count);
+void _intParBuild(void *arg);
+void _intFreeSubtree(AVLIntNode *node);
+void *_intFold(AVLIntParFold *fold, AVLIntNode *node, void *acc);
+void _intParFold(void *arg);
 
 // USER FUNCTIONS //
 /* Creates a new AVL Tree in the heap. */
@@ -51,6 +234,27 @@ AVLIntTree *createIntTree(void) {
     newTree->_root = NULL;
     newTree->nodesCount = 0;
     newTree->maxNodes = ULONG_MAX;
+    newTree->_cache = NULL;
+    newTree->_cacheBits = 0;
+    newTree->cacheHits = 0;
+    newTree->cacheMisses = 0;
+    newTree->_index = NULL;
+    newTree->_indexBits = 0;
+    newTree->_indexUsed = 0;
+    newTree->_finger = NULL;
+    newTree->_minNode = NULL;
+    newTree->_maxNode = NULL;
+    memset(&(newTree->_augment), 0, sizeof(AVLIntAugment));
+    newTree->_evictPolicy = 0;
+    newTree->_evictOpts = 0;
+    newTree->_newest = NULL;
+    newTree->_oldest = NULL;
+    newTree->_bufKeys = NULL;
+    newTree->_bufData = NULL;
+    newTree->_buffered = 0;
+    newTree->_bufCapacity = 0;
+    newTree->memUsed = sizeof(AVLIntTree);
+    newTree->_budget = NULL;
     return newTree;
 }
 
@@ -61,6 +265,12 @@ int deleteIntTree(AVLIntTree *tree, int opts) {
     // Sanity check on input arguments.
     if (tree == NULL) return -1;
     if (opts < 0) return -1;
+    // Everything the tree is using goes back to its budget.
+    memBudgetRelease(tree->_budget, tree->memUsed);
+    // Buffered entries have no nodes, so just drop them.
+    _intFreeBuffer(tree, opts);
+    free(tree->_cache);
+    free(tree->_index);
     // If the tree is empty free it directly.
     if (tree->_root == NULL) {
         free(tree);
@@ -80,11 +290,23 @@ int deleteIntTree(AVLIntTree *tree, int opts) {
     return 0;
 }
 
-/* Searches for an entry with the specified key in the tree. */
+/* Searches for an entry with the specified key in the tree, buffer included.
+ * Since buffered entries have no nodes, SEARCH_NODES only finds those in the
+ * tree: flush the buffer first to find them all.
+ * Searches don't modify the tree, so they can run concurrently, UNLESS the
+ * tree evicts the least recently used entries (EVICT_LRU): then the entry
+ * found becomes the most recently used, and searches need exclusive access.
+ */
 void *intSearch(AVLIntTree *tree, int key, int opts) {
     if ((opts <= 0) || (tree == NULL)) return NULL;  // Sanity check.
+    if (opts & SEARCH_DATA) {
+        unsigned long int pos = _intBufferSearch(tree, key);
+        if ((pos < tree->_buffered) && (tree->_bufKeys[pos] == key))
+            return tree->_bufData[pos];
+    }
     AVLIntNode *searchedNode = _searchIntNode(tree, key);
     if (searchedNode != NULL) {
+        if (tree->_evictPolicy & EVICT_LRU) _intUseNode(tree, searchedNode);
         if (opts & SEARCH_DATA) return searchedNode->_data;
         if (opts & SEARCH_NODES) return searchedNode;
         return NULL;
@@ -92,70 +314,282 @@ void *intSearch(AVLIntTree *tree, int key, int opts) {
     return NULL;
 }
 
-/* Deletes an entry from the tree. */
+/* Deletes an entry from the tree. Buffered entries are deleted first, so that
+ * a deletion cancels a recent insertion without touching the tree.
+ */
 int intDelete(AVLIntTree *tree, int key, int opts) {
     // Sanity check on input arguments.
     if ((opts < 0) || (tree == NULL)) return 0;
-    AVLIntNode *toDelete = _searchIntNode(tree, key);
-    AVLIntNode *toFree;
-    if (toDelete != NULL) {
-        // Check whether the node has no sons or even one.
-        if ((toDelete->_leftSon == NULL) || (toDelete->_rightSon == NULL)) {
-            toFree = _intCutOneSonNode(toDelete);
-        } else {
-            // Find the node's predecessor and swap the content.
-            AVLIntNode *maxLeft = _intMaxKeySon(toDelete->_leftSon);
-            _intSwapInfo(toDelete, maxLeft);
-            // Remove the original predecessor.
-            toFree = _intCutOneSonNode(maxLeft);
-        }
-        // Apply eventual options to free keys and data, then free the node.
-        if (opts & DELETE_FREE_DATA) free(toFree->_data);
-        free(toFree);
+    unsigned long int pos = _intBufferSearch(tree, key);
+    if ((pos < tree->_buffered) && (tree->_bufKeys[pos] == key)) {
+        if (opts & DELETE_FREE_DATA) free(tree->_bufData[pos]);
+        _intBufferRemove(tree, pos, 1);
+        _intRelease(tree, ENTRY_BYTES(tree));
         tree->nodesCount--;
-        // Check if the tree is now empty and update root pointer.
-        if (tree->nodesCount == 0) tree->_root = NULL;
         return 1;  // Found and deleted.
     }
+    AVLIntNode *toDelete = _searchIntNode(tree, key);
+    if (toDelete != NULL) return intDeleteNode(tree, toDelete, opts);
     return 0;  // Not found.
 }
 
-/* Creates and inserts a new node in the tree. */
+/* Deletes the entry held by a given node of the tree, as returned by searches
+ * with SEARCH_NODES: useful to choose among entries with the same key.
+ * Returns 1 if the entry was deleted, 0 otherwise.
+ */
+int intDeleteNode(AVLIntTree *tree, AVLIntNode *node, int opts) {
+    // Sanity check on input arguments.
+    if ((opts < 0) || (tree == NULL) || (node == NULL)) return 0;
+    // The nodes next to the extremes take their place.
+    if (tree->_minNode == node)
+        tree->_minNode = _intTraverseNext(tree->_root, node, DFS_IN_ORDER,
+                                          NULL);
+    if (tree->_maxNode == node) tree->_maxNode = _intPrevNode(node);
+    // Unlink the node, then forget about it.
+    _intDeleteNode(tree, node);
+    _intCacheForget(tree, node);
+    _intIndexRemove(tree, node);
+    if (tree->_finger == node) tree->_finger = NULL;
+    if (tree->_evictPolicy & EVICT_LRU) _intForgetUse(tree, node);
+    // Apply eventual options to free keys and data, then free the node.
+    if (opts & DELETE_FREE_DATA) free(node->_data);
+    _deleteIntNode(node);
+    _intRelease(tree, ENTRY_BYTES(tree));
+    tree->nodesCount--;
+    return 1;
+}
+
+/* Creates and inserts a new entry in the tree, or in its buffer if it has
+ * one, which gets flushed first if full. The memory for the entry is charged
+ * to the tree's budget, if it has one, even if it's buffered. Then, if the
+ * tree is full, an entry is evicted, if it has an eviction policy.
+ * Returns the new number of entries, or 0 if the insertion failed or the
+ * budget refused it.
+ */
 unsigned long int intInsert(AVLIntTree *tree, int newKey, void *newData) {
     if (tree == NULL) return 0;  // Sanity check.
-    if (tree->nodesCount == tree->maxNodes) return 0;  // The tree is full.
-    AVLIntNode *newNode = _createIntNode(newKey, newData);
-    if (tree->_root == NULL) {
-        // The tree is empty.
-        tree->_root = newNode;
-        tree->nodesCount++;
-    } else {
-        // Look for the correct position and place it there.
-        AVLIntNode *curr = tree->_root;
-        AVLIntNode *pred = NULL;
-        int comp;
-        while (curr != NULL) {
-            pred = curr;
-            comp = curr->_key - newKey;
-            if (comp >= 0) {
-                // Equals are kept in the left subtree.
-                curr = curr->_leftSon;
-            } else {
-                curr = curr->_rightSon;
-            }
+    // Reserve the memory first, so that nothing is evicted for nothing.
+    if (_intCharge(tree, ENTRY_BYTES(tree), 0) != 0) return 0;
+    if (((tree->_bufCapacity == 0) && (_intIndexReserve(tree, 1) != 0)) ||
+        ((tree->nodesCount >= tree->maxNodes) && (_intEvict(tree) != 0))) {
+        // The tree is full and there's no room to make.
+        _intRelease(tree, ENTRY_BYTES(tree));
+        return 0;
+    }
+    if (tree->_bufCapacity > 0) {
+        if ((tree->_buffered == tree->_bufCapacity) &&
+            (intFlushBuffer(tree) != 0)) {
+            _intRelease(tree, ENTRY_BYTES(tree));
+            return 0;
         }
-        comp = pred->_key - newKey;
-        if (comp >= 0) {
-            _intInsertAsLeftSubtree(pred, newNode);
-        } else {
-            _intInsertAsRightSubtree(pred, newNode);
+        _intBufferInsert(tree, newKey, newData);
+    } else if (_intTreeInsert(tree, NULL, newKey, newData) == NULL) {
+        _intRelease(tree, ENTRY_BYTES(tree));
+        return 0;
+    }
+    tree->nodesCount++;
+    return tree->nodesCount;  // Return the result of the insertion.
+}
+
+/* Searches for an entry like intSearch, but starting from a given node of the
+ * tree (the "finger") instead of from the root, or from the last node found or
+ * inserted by these finger functions if it's NULL. The search climbs from the
+ * finger only as far as needed to reach a subtree that can hold the key, so
+ * the fewer entries lie between the finger and the key, the cheaper it is: this
+ * pays off when keys are looked for in (nearly) sorted order.
+ * A node found becomes the tree's finger. Concurrent searches remain safe, as
+ * long as the node given, if any, is not deleted, UNLESS the tree evicts the
+ * least recently used entries (EVICT_LRU), as with intSearch.
+ */
+void *intFingerSearch(AVLIntTree *tree, AVLIntNode *finger, int key,
+                      int opts) {
+    if ((opts <= 0) || (tree == NULL)) return NULL;  // Sanity check.
+    if (opts & SEARCH_DATA) {
+        unsigned long int pos = _intBufferSearch(tree, key);
+        if ((pos < tree->_buffered) && (tree->_bufKeys[pos] == key))
+            return tree->_bufData[pos];
+    }
+    if (finger == NULL)
+        finger = __atomic_load_n(&(tree->_finger), __ATOMIC_RELAXED);
+    AVLIntNode *searchedNode;
+    if ((finger == NULL) || (tree->_index != NULL)) {
+        // There's nowhere to start from, or a faster way.
+        searchedNode = _searchIntNode(tree, key);
+    } else searchedNode = _intFingerSearch(finger, key);
+    if (searchedNode != NULL) {
+        __atomic_store_n(&(tree->_finger), searchedNode, __ATOMIC_RELAXED);
+        if (tree->_evictPolicy & EVICT_LRU) _intUseNode(tree, searchedNode);
+        if (opts & SEARCH_DATA) return searchedNode->_data;
+        if (opts & SEARCH_NODES) return searchedNode;
+        return NULL;
+    }
+    return NULL;
+}
+
+/* Tells which of the given keys are in the tree, buffer included, setting the
+ * i-th bit of the bitmap (counting from the least significant bit of its first
+ * byte) if the i-th key is there, and clearing it otherwise. The bitmap must
+ * hold at least n bits.
+ * Keys should be sorted: each one is then looked for starting from where the
+ * previous one was, or would have been, like intFingerSearch does, so keys
+ * close to each other in the tree cost little more than a step of an in-order
+ * visit, and distant ones not much more than a descent from the root. The
+ * results are correct for keys in any order, though.
+ * Returns the number of keys found.
+ */
+unsigned long int intContainsSorted(AVLIntTree *tree, int *keys,
+                                    unsigned long int n,
+                                    unsigned char *bitmap) {
+    // Sanity check on input arguments.
+    if ((tree == NULL) || (keys == NULL) || (bitmap == NULL)) return 0;
+    unsigned long int found = 0, pos = 0;
+    AVLIntNode *finger = NULL, *curr, *last;
+    int comp, present;
+    for (unsigned long int i = 0; i < n; i++) {
+        present = 0;
+        // The buffer is sorted too, so it's merged with the keys.
+        if ((pos > 0) && (tree->_bufKeys[pos - 1] >= keys[i])) pos = 0;
+        while ((pos < tree->_buffered) && (tree->_bufKeys[pos] < keys[i]))
+            pos++;
+        if ((pos < tree->_buffered) && (tree->_bufKeys[pos] == keys[i])) {
+            present = 1;
+        } else if (tree->_index != NULL) {
+            present = _intIndexLookup(tree, keys[i]) != NULL;
+        } else if (tree->_root != NULL) {
+            // Descend from where the previous key was left.
+            curr = (finger != NULL) ? _intFingerStart(finger, keys[i]) :
+                   tree->_root;
+            last = curr;
+            while (curr != NULL) {
+                last = curr;
+                comp = COMPARE(curr->_key, keys[i]);
+                if (comp > 0) {
+                    curr = curr->_leftSon;
+                } else if (comp < 0) {
+                    curr = curr->_rightSon;
+                } else {
+                    present = 1;
+                    break;
+                }
+            }
+            finger = last;
         }
-        _intBalanceInsert(newNode);
-        tree->nodesCount++;
+        if (present) {
+            bitmap[i >> 3] |= (unsigned char) (1U << (i & 7));
+            found++;
+        } else bitmap[i >> 3] &= (unsigned char) ~(1U << (i & 7));
+    }
+    return found;
+}
+
+/* Creates and inserts a new entry in the tree like intInsert, but looking for
+ * its place starting from a given node of the tree (the "finger"), or from the
+ * last node found or inserted by these finger functions if it's NULL, as
+ * intFingerSearch does. Inserting (nearly) sorted keys this way costs little
+ * more than linking and rebalancing, since the place of each is close to the
+ * previous one.
+ * The entry goes straight into the tree, even if it has a buffer, and its node
+ * becomes the tree's finger. The given node must survive the eviction and the
+ * pressure callback of the budget that may precede the insertion.
+ * Returns the new number of entries, or 0 if the insertion failed or the
+ * budget refused it.
+ */
+unsigned long int intFingerInsert(AVLIntTree *tree, AVLIntNode *finger,
+                                  int newKey, void *newData) {
+    if (tree == NULL) return 0;  // Sanity check.
+    // Reserve the memory first, so that nothing is evicted for nothing.
+    if (_intCharge(tree, ENTRY_BYTES(tree), 0) != 0) return 0;
+    if ((_intIndexReserve(tree, 1) != 0) ||
+        ((tree->nodesCount >= tree->maxNodes) && (_intEvict(tree) != 0))) {
+        // The tree is full and there's no room to make.
+        _intRelease(tree, ENTRY_BYTES(tree));
+        return 0;
+    }
+    if (finger == NULL) finger = tree->_finger;
+    AVLIntNode *newNode = _intTreeInsert(tree, finger, newKey, newData);
+    if (newNode == NULL) {
+        _intRelease(tree, ENTRY_BYTES(tree));
+        return 0;
     }
+    tree->_finger = newNode;
+    tree->nodesCount++;
     return tree->nodesCount;  // Return the result of the insertion.
 }
 
+/* Gives the tree a direct-mapped cache of the nodes found by searches, with
+ * the given number of slots (rounded up to a power of two, up to
+ * 2^CACHE_MAX_BITS), or removes it if the size is zero. Each key can only be
+ * cached in one slot, so searching it again costs a hash and a single
+ * comparison as long as no other key took its slot. Hits and misses are
+ * counted in the tree, and reset by this call.
+ * Concurrent searches remain safe, since the cache is updated atomically
+ * (unless the tree evicts the least recently used entries, see intSearch).
+ * Returns 0 if successful, -1 if memory could not be allocated or the tree's
+ * budget refused it.
+ */
+int intSetCache(AVLIntTree *tree, unsigned long int size) {
+    if (tree == NULL) return -1;  // Sanity check.
+    AVLIntNode **newCache = NULL;
+    int bits = 0;
+    if (size > 0) {
+        while (((1UL << bits) < size) && (bits < CACHE_MAX_BITS))
+            bits++;
+        if (bits == 0) bits = 1;
+        if (_intCharge(tree, (1UL << bits) * sizeof(AVLIntNode *), 0) != 0)
+            return -1;
+        newCache = (AVLIntNode **) calloc(1UL << bits, sizeof(AVLIntNode *));
+        if (newCache == NULL) {
+            _intRelease(tree, (1UL << bits) * sizeof(AVLIntNode *));
+            return -1;
+        }
+    }
+    if (tree->_cache != NULL)
+        _intRelease(tree, (1UL << tree->_cacheBits) * sizeof(AVLIntNode *));
+    free(tree->_cache);
+    tree->_cache = newCache;
+    tree->_cacheBits = bits;
+    tree->cacheHits = 0;
+    tree->cacheMisses = 0;
+    return 0;
+}
+
+/* Gives the tree a hash index that maps each key to its node, or removes it.
+ * The index is kept up to date by insertions and deletions, and lets exact
+ * searches (and the searches done by deletions) skip the descent of the tree,
+ * while visits keep using the tree. It uses open addressing with linear
+ * probing, and doubles its size when half of its slots are in use.
+ * Growing it while inserting is charged to the tree's budget, if it has one,
+ * before the entries are inserted: the insertion fails (or, when flushing the
+ * buffer, the entries stay buffered) if the budget refuses it.
+ * Returns 0 if successful, -1 if memory could not be allocated or the tree's
+ * budget refused it.
+ */
+int intSetIndex(AVLIntTree *tree, int enable) {
+    if (tree == NULL) return -1;  // Sanity check.
+    if (!enable) {
+        _intRelease(tree, intIndexMemory(tree));
+        free(tree->_index);
+        tree->_index = NULL;
+        tree->_indexBits = 0;
+        tree->_indexUsed = 0;
+        return 0;
+    }
+    if (tree->_index != NULL) return 0;  // Nothing to do.
+    // Start with enough slots for all the nodes.
+    unsigned long int count = _intSize(tree->_root);
+    int bits = 4;
+    while ((count << INDEX_LOAD_SHIFT) >= (1UL << bits)) bits++;
+    return _intIndexResize(tree, bits, 0);
+}
+
+/* Returns the number of bytes of memory used by the tree's hash index, which
+ * is what it adds to the memory used by the nodes.
+ */
+unsigned long int intIndexMemory(AVLIntTree *tree) {
+    if ((tree == NULL) || (tree->_index == NULL)) return 0;  // Sanity check.
+    return (1UL << tree->_indexBits) * sizeof(AVLIntIndexSlot);
+}
+
 /* Performs a depth-first search of the tree, the type of which can be
  * specified using the options defined in the header.
  * Depending on the option specified, returns an array of:
@@ -168,6 +602,8 @@ unsigned long int intInsert(AVLIntTree *tree, int newKey, void *newData) {
 void **intDFS(AVLIntTree *tree, int type, int opts) {
     // Sanity check for the input arguments.
     if ((type <= 0) || (opts <= 0)) return NULL;
+    // Buffered entries can't be visited: they must be flushed first.
+    if ((tree != NULL) && (tree->_buffered > 0)) return NULL;
     if ((tree == NULL) || (tree->_root == NULL)) return NULL;
     // Allocate memory according to options.
     void **dfsRes;
@@ -211,6 +647,8 @@ void **intDFS(AVLIntTree *tree, int type, int opts) {
  * Remember to free the returned array afterwards!
  */
 void **intBFS(AVLIntTree *tree, int type, int opts) {
+    // Buffered entries can't be visited: they must be flushed first.
+    if ((tree != NULL) && (tree->_buffered > 0)) return NULL;
     // Sanity check on input arguments.
     if ((tree == NULL) || (tree->_root == NULL) ||
         (type <= 0) || (opts <= 0) ||
@@ -281,17 +719,760 @@ void **intBFS(AVLIntTree *tree, int type, int opts) {
     return bfsRes;
 }
 
+/* Performs a breadth-first search of the tree like intBFS, one level at a
+ * time, stopping after the given depth (the root's being 0), or at the last
+ * level if it's negative.
+ * The returned array holds the levels one after the other, and the number of
+ * levels visited is stored in nLevels. The position in the array at which
+ * each level starts is stored in a new array, which levels is made to point
+ * to, with one more element at the end holding the number of entries
+ * returned, so that the i-th level goes from (*levels)[i] up to
+ * (*levels)[i + 1].
+ * Only the nodes of the level being visited and those of the next one are
+ * kept aside, in buffers that grow with the levels, which are charged to the
+ * tree's budget, if it has one, while the visit runs: the visit fails if the
+ * budget refuses them.
+ * Remember to free both returned arrays afterwards!
+ */
+void **intLevelBFS(AVLIntTree *tree, int type, int opts, int maxDepth,
+                   unsigned long int **levels, int *nLevels) {
+    // Sanity check for the input arguments.
+    if ((type <= 0) || (opts <= 0)) return NULL;
+    if ((levels == NULL) || (nLevels == NULL)) return NULL;
+    int leftFirst;
+    if (type & BFS_LEFT_FIRST) {
+        leftFirst = 1;
+    } else if (type & BFS_RIGHT_FIRST) {
+        leftFirst = 0;
+    } else return NULL;  // Invalid type.
+    // Buffered entries can't be visited: they must be flushed first.
+    if ((tree != NULL) && (tree->_buffered > 0)) return NULL;
+    if ((tree == NULL) || (tree->_root == NULL)) return NULL;
+    if ((maxDepth < 0) || (maxDepth > tree->_root->_height))
+        maxDepth = tree->_root->_height;
+    // No more than 2^(d + 1) - 1 nodes can be found down to depth d.
+    unsigned long int total = tree->nodesCount;
+    if ((maxDepth < (int) (sizeof(unsigned long int) * CHAR_BIT) - 1) &&
+        ((1UL << (maxDepth + 1)) - 1 < total))
+        total = (1UL << (maxDepth + 1)) - 1;
+    // Allocate memory according to options.
+    int intOpt;
+    void *bfsRes = _intAllocVisit(total, opts, &intOpt);
+    unsigned long int *offsets = (unsigned long int *) calloc(
+        maxDepth + 2, sizeof(unsigned long int));
+    unsigned long int currCap = 0, nextCap = 0, tmpCap;
+    AVLIntNode **curr = NULL;
+    AVLIntNode **next = NULL;
+    AVLIntNode **tmp;
+    int failed = (bfsRes == NULL) || (offsets == NULL) ||
+                 (_intGrowFrontier(tree, &curr, &currCap, 1) != 0);
+    // Visit the levels, collecting each one's sons as the next one.
+    unsigned long int width = 1, nextWidth, pos = 0;
+    AVLIntNode *first, *second;
+    if (!failed) curr[0] = tree->_root;
+    for (int depth = 0; (depth <= maxDepth) && !failed; depth++) {
+        offsets[depth] = pos;
+        for (unsigned long int i = 0; i < width; i++)
+            _intStoreEntry(bfsRes, pos++, curr[i], intOpt);
+        if (depth == maxDepth) break;
+        if (_intGrowFrontier(tree, &next, &nextCap, 2 * width) != 0) {
+            failed = 1;
+            break;
+        }
+        nextWidth = 0;
+        for (unsigned long int i = 0; i < width; i++) {
+            first = leftFirst ? curr[i]->_leftSon : curr[i]->_rightSon;
+            second = leftFirst ? curr[i]->_rightSon : curr[i]->_leftSon;
+            if (first != NULL) next[nextWidth++] = first;
+            if (second != NULL) next[nextWidth++] = second;
+        }
+        tmp = curr;
+        curr = next;
+        next = tmp;
+        tmpCap = currCap;
+        currCap = nextCap;
+        nextCap = tmpCap;
+        width = nextWidth;
+    }
+    free(curr);
+    free(next);
+    _intRelease(tree, (currCap + nextCap) * sizeof(AVLIntNode *));
+    if (failed) {
+        free(bfsRes);
+        free(offsets);
+        return NULL;
+    }
+    offsets[maxDepth + 1] = pos;
+    *levels = offsets;
+    *nLevels = maxDepth + 1;
+    return (void **) bfsRes;
+}
+
+/* Resets a cursor, so that the next visit that uses it starts over. */
+void intResetCursor(AVLIntCursor *cursor) {
+    if (cursor == NULL) return;  // Sanity check.
+    cursor->_node = NULL;
+    cursor->_depth = 0;
+    cursor->_type = 0;
+    cursor->_started = 0;
+}
+
+/* Performs a visit of the tree like intDFS or intBFS (any of their types can
+ * be specified), but stores the keys and/or the data of the entries in the
+ * given arrays, either of which can be NULL, instead of allocating a new one.
+ * At most capacity entries are stored: the cursor remembers where the visit
+ * stopped, so that the next call with the same cursor resumes it from there
+ * (the type given to the first call is used until the cursor is reset).
+ * Moving from an entry to the next one only requires following the links
+ * between the nodes, so nothing is allocated.
+ * Returns the number of entries stored, which is 0 once the visit is over.
+ */
+unsigned long int intTraverseInto(AVLIntTree *tree, int type, int *keys,
+                                  void **data, unsigned long int capacity,
+                                  AVLIntCursor *cursor) {
+    // Sanity check on input arguments.
+    if ((tree == NULL) || (cursor == NULL)) return 0;
+    if ((keys == NULL) && (data == NULL)) return 0;
+    if (!(cursor->_started)) {
+        if (type & DFS_PRE_ORDER) {
+            cursor->_type = DFS_PRE_ORDER;
+        } else if (type & DFS_IN_ORDER) {
+            cursor->_type = DFS_IN_ORDER;
+        } else if (type & DFS_POST_ORDER) {
+            cursor->_type = DFS_POST_ORDER;
+        } else if (type & BFS_LEFT_FIRST) {
+            cursor->_type = BFS_LEFT_FIRST;
+        } else if (type & BFS_RIGHT_FIRST) {
+            cursor->_type = BFS_RIGHT_FIRST;
+        } else return 0;  // Invalid type.
+        // Buffered entries can't be visited: they must be flushed first.
+        if (tree->_buffered > 0) return 0;
+        cursor->_node = _intTraverseFirst(tree->_root, cursor->_type);
+        cursor->_depth = 0;
+        cursor->_started = 1;
+    }
+    unsigned long int count = 0;
+    AVLIntNode *curr = cursor->_node;
+    while ((curr != NULL) && (count < capacity)) {
+        if (keys != NULL) keys[count] = curr->_key;
+        if (data != NULL) data[count] = curr->_data;
+        count++;
+        curr = _intTraverseNext(tree->_root, curr, cursor->_type,
+                                &(cursor->_depth));
+    }
+    cursor->_node = curr;
+    return count;
+}
+
+/* Draws k entries of the tree at random, each one independently of the others
+ * and with the same probability, storing their keys and/or data in the given
+ * arrays, either of which can be NULL.
+ * Random numbers come from nrand48, using the given state, which the caller
+ * must have initialized (e.g. with the current time). Each entry is found by
+ * its position, using the subtree sizes stored in the nodes, so each draw
+ * costs a single descent from the root.
+ * Returns the number of entries drawn: k, or 0 if the tree is empty.
+ */
+unsigned long int intSampleRandom(AVLIntTree *tree, unsigned short rng[3],
+                                  unsigned long int k, int *keys,
+                                  void **data) {
+    // Sanity check on input arguments.
+    if ((tree == NULL) || (rng == NULL)) return 0;
+    if ((keys == NULL) && (data == NULL)) return 0;
+    // Buffered entries can't be drawn: they must be flushed first.
+    if (tree->_buffered > 0) return 0;
+    if (tree->_root == NULL) return 0;
+    AVLIntNode *node;
+    for (unsigned long int i = 0; i < k; i++) {
+        node = _intSelectNode(tree->_root,
+                              _intRandomRank(rng, tree->nodesCount));
+        if (keys != NULL) keys[i] = node->_key;
+        if (data != NULL) data[i] = node->_data;
+    }
+    return k;
+}
+
+/* Draws k entries of the tree at random like intSampleRandom, but returns them
+ * sorted by key. All the positions are drawn and sorted first, then the
+ * entries are collected from left to right: those close to the previous one
+ * are reached by moving forward from it, the others with a new descent, so
+ * that big samples cost little more than a visit of the tree. The positions
+ * are charged to the tree's budget, if it has one, while they are needed.
+ * Returns the number of entries drawn: k, or 0 if the tree is empty, memory
+ * could not be allocated or the budget refused it.
+ */
+unsigned long int intSampleSorted(AVLIntTree *tree, unsigned short rng[3],
+                                  unsigned long int k, int *keys,
+                                  void **data) {
+    // Sanity check on input arguments.
+    if ((tree == NULL) || (rng == NULL)) return 0;
+    if ((keys == NULL) && (data == NULL)) return 0;
+    // Buffered entries can't be drawn: they must be flushed first.
+    if (tree->_buffered > 0) return 0;
+    if ((tree->_root == NULL) || (k == 0)) return 0;
+    if (_intCharge(tree, k * sizeof(unsigned long int), 1) != 0) return 0;
+    unsigned long int *ranks = (unsigned long int *) malloc(
+        k * sizeof(unsigned long int));
+    if (ranks == NULL) {
+        _intRelease(tree, k * sizeof(unsigned long int));
+        return 0;
+    }
+    for (unsigned long int i = 0; i < k; i++)
+        ranks[i] = _intRandomRank(rng, tree->nodesCount);
+    qsort(ranks, k, sizeof(unsigned long int), _intCompareRanks);
+    // Moving forward is worth it while it takes no longer than a descent.
+    unsigned long int maxSteps = (unsigned long int) tree->_root->_height + 1;
+    AVLIntNode *node = NULL;
+    unsigned long int rank = 0;
+    for (unsigned long int i = 0; i < k; i++) {
+        if ((node != NULL) && (ranks[i] - rank <= maxSteps)) {
+            for (; rank < ranks[i]; rank++)
+                node = _intTraverseNext(tree->_root, node, DFS_IN_ORDER,
+                                        NULL);
+        } else {
+            rank = ranks[i];
+            node = _intSelectNode(tree->_root, rank);
+        }
+        if (keys != NULL) keys[i] = node->_key;
+        if (data != NULL) data[i] = node->_data;
+    }
+    free(ranks);
+    _intRelease(tree, k * sizeof(unsigned long int));
+    return k;
+}
+
+/* Stores in the given arrays, either of which can be NULL, the keys and data
+ * of the k entries with the greatest keys, buffer included, from the greatest
+ * down. The visit starts from the rightmost node and moves back from there, so
+ * it costs k steps, regardless of the size of the tree.
+ * Returns the number of entries stored: k, or fewer if the tree holds less.
+ */
+unsigned long int intTopK(AVLIntTree *tree, unsigned long int k, int *keys,
+                          void **data) {
+    // Sanity check on input arguments.
+    if ((tree == NULL) || ((keys == NULL) && (data == NULL))) return 0;
+    return _intTakeExtremes(tree, k, keys, data, 1);
+}
+
+/* Stores the keys and data of the k entries with the smallest keys, from the
+ * smallest up, like intTopK.
+ * Returns the number of entries stored: k, or fewer if the tree holds less.
+ */
+unsigned long int intBottomK(AVLIntTree *tree, unsigned long int k, int *keys,
+                             void **data) {
+    // Sanity check on input arguments.
+    if ((tree == NULL) || ((keys == NULL) && (data == NULL))) return 0;
+    return _intTakeExtremes(tree, k, keys, data, 0);
+}
+
+/* Stores the smallest key in the tree, buffer included, and its data, where
+ * given (either pointer can be NULL), in constant time.
+ * Returns 1 if the tree holds some entries, 0 if it's empty.
+ */
+int intMin(AVLIntTree *tree, int *key, void **data) {
+    if (tree == NULL) return 0;  // Sanity check.
+    return (int) _intTakeExtremes(tree, 1, key, data, 0);
+}
+
+/* Stores the greatest key in the tree and its data, like intMin.
+ * Returns 1 if the tree holds some entries, 0 if it's empty.
+ */
+int intMax(AVLIntTree *tree, int *key, void **data) {
+    if (tree == NULL) return 0;  // Sanity check.
+    return (int) _intTakeExtremes(tree, 1, key, data, 1);
+}
+
+/* Removes the entry with the smallest key from the tree, buffer included,
+ * storing its key and data where given (either pointer can be NULL), like a
+ * priority queue would. Finding it takes constant time, and removing it
+ * costs as much as deleting any other node. Its data is not freed, since it's
+ * handed back.
+ * Returns 1 if an entry was removed, 0 if the tree is empty.
+ */
+int intPopMin(AVLIntTree *tree, int *key, void **data) {
+    if (tree == NULL) return 0;  // Sanity check.
+    return _intPopExtreme(tree, key, data, 0);
+}
+
+/* Removes the entry with the greatest key from the tree, like intPopMin.
+ * Returns 1 if an entry was removed, 0 if the tree is empty.
+ */
+int intPopMax(AVLIntTree *tree, int *key, void **data) {
+    if (tree == NULL) return 0;  // Sanity check.
+    return _intPopExtreme(tree, key, data, 1);
+}
+
+/* Sets how the nodes of the tree are augmented with summaries of their
+ * subtrees (see the header), or stops augmenting them if augment is NULL.
+ * Since nodes are allocated with room for their summaries, this can only be
+ * done while the tree is empty.
+ * The summary size is rounded up so that the summaries of all the nodes are
+ * suitably aligned.
+ * Returns 0 if successful, -1 if the tree is not empty or the description is
+ * not valid.
+ */
+int intSetAugment(AVLIntTree *tree, const AVLIntAugment *augment) {
+    if (tree == NULL) return -1;  // Sanity check.
+    if (tree->nodesCount > 0) return -1;
+    if (augment == NULL) {
+        memset(&(tree->_augment), 0, sizeof(AVLIntAugment));
+        return 0;
+    }
+    if ((augment->augSize == 0) || (augment->entry == NULL) ||
+        (augment->combine == NULL)) return -1;
+    tree->_augment = *augment;
+    tree->_augment.augSize = (augment->augSize + sizeof(max_align_t) - 1) /
+                             sizeof(max_align_t) * sizeof(max_align_t);
+    return 0;
+}
+
+/* Computes the summary of all the entries with keys between lo and hi
+ * (included), storing it in result, which must be as big as a summary.
+ * Whole subtrees within the range contribute with their stored summaries, so
+ * only two paths from the root are followed.
+ * Returns 1 if the range holds some entries, 0 if it doesn't (and result is
+ * left untouched), -1 if the tree is not augmented or has buffered entries.
+ */
+int intRangeAggregate(AVLIntTree *tree, int lo, int hi, void *result) {
+    // Sanity check on input arguments.
+    if ((tree == NULL) || (result == NULL)) return -1;
+    if (tree->_augment.augSize == 0) return -1;
+    // Buffered entries can't be summarized: they must be flushed first.
+    if (tree->_buffered > 0) return -1;
+    AVLIntAugment *augment = &(tree->_augment);
+    // Look for the highest node in the range: all the others are below it.
+    AVLIntNode *top = tree->_root;
+    while ((top != NULL) && ((top->_key < lo) || (top->_key > hi)))
+        top = top->_key < lo ? top->_rightSon : top->_leftSon;
+    if (top == NULL) return 0;
+    max_align_t piece[augment->augSize / sizeof(max_align_t)];
+    augment->entry(result, top->_key, top->_data, augment->ctx);
+    // Walk towards lo, adding on the left the nodes in the range and their
+    // right subtrees.
+    AVLIntNode *curr = top->_leftSon;
+    while (curr != NULL) {
+        if (curr->_key >= lo) {
+            augment->entry(piece, curr->_key, curr->_data, augment->ctx);
+            if (curr->_rightSon != NULL)
+                augment->combine(piece, piece, AUGMENT(curr->_rightSon),
+                                 augment->ctx);
+            augment->combine(result, piece, result, augment->ctx);
+            curr = curr->_leftSon;
+        } else curr = curr->_rightSon;
+    }
+    // Walk towards hi, adding on the right the nodes in the range and their
+    // left subtrees.
+    curr = top->_rightSon;
+    while (curr != NULL) {
+        if (curr->_key <= hi) {
+            augment->entry(piece, curr->_key, curr->_data, augment->ctx);
+            if (curr->_leftSon != NULL)
+                augment->combine(piece, AUGMENT(curr->_leftSon), piece,
+                                 augment->ctx);
+            augment->combine(result, result, piece, augment->ctx);
+            curr = curr->_rightSon;
+        } else curr = curr->_leftSon;
+    }
+    return 1;
+}
+
+/* Limits the number of entries in the tree to maxNodes, specifying which one
+ * to evict, using the options defined in the header, when a new entry comes
+ * in and the tree is full. Evicted entries are deleted with the given options.
+ * With no policy (0), insertions simply fail when the tree is full.
+ * Keeping track of the least recently used entry requires keeping all nodes in
+ * a list, updated by insertions and successful searches: the entries already
+ * in the tree are put there in order of their keys, as if the smallest was the
+ * least recently used. This makes searches modify the tree: with EVICT_LRU,
+ * they can no longer run concurrently with each other.
+ * If there are more than maxNodes entries already, and there's a policy, the
+ * extra ones are evicted right away.
+ * Returns 0 if successful, -1 if the policy is not valid or buffered entries
+ * could not be moved into the tree.
+ */
+int intSetCapacity(AVLIntTree *tree, unsigned long int maxNodes, int policy,
+                   int opts) {
+    // Sanity check on input arguments.
+    if ((tree == NULL) || (opts < 0)) return -1;
+    if ((policy != 0) && (policy != EVICT_MIN_KEY) &&
+        (policy != EVICT_MAX_KEY) && (policy != EVICT_LRU)) return -1;
+    if ((policy & EVICT_LRU) && !(tree->_evictPolicy & EVICT_LRU)) {
+        // List the nodes, with an in-order visit that ends at the newest.
+        if (intFlushBuffer(tree) != 0) return -1;
+        tree->_newest = NULL;
+        tree->_oldest = NULL;
+        AVLIntNode *curr = _intTraverseFirst(tree->_root, DFS_IN_ORDER);
+        while (curr != NULL) {
+            curr->_newer = NULL;
+            curr->_older = NULL;
+            _intUseNode(tree, curr);
+            curr = _intTraverseNext(tree->_root, curr, DFS_IN_ORDER, NULL);
+        }
+    }
+    tree->maxNodes = maxNodes;
+    tree->_evictPolicy = policy;
+    tree->_evictOpts = opts;
+    if (!(policy & EVICT_LRU)) {
+        tree->_newest = NULL;
+        tree->_oldest = NULL;
+    }
+    while ((policy != 0) && (tree->nodesCount > maxNodes))
+        if (_intEvict(tree) != 0) return -1;
+    return 0;
+}
+
+/* Evicts entries from the tree, as its policy says, until the given number of
+ * bytes has been freed, or there's nothing left to evict: meant to be called
+ * by the pressure callbacks of memory budgets.
+ * Returns the number of bytes freed.
+ */
+unsigned long int intShed(AVLIntTree *tree, unsigned long int bytes) {
+    if (tree == NULL) return 0;  // Sanity check.
+    unsigned long int freed = 0, before;
+    while (freed < bytes) {
+        // Count what each eviction actually gave back.
+        before = tree->memUsed;
+        if (_intEvict(tree) != 0) break;
+        if (tree->memUsed < before) freed += before - tree->memUsed;
+    }
+    return freed;
+}
+
+/* Charges the memory used by the tree to a budget, which can be shared with
+ * other trees, moving it from the one it had, if any, or removes the tree from
+ * its budget if it's NULL. The tree is charged all its memory even if that
+ * exceeds the budget's limit, but then it can't grow until there's room.
+ * Operations that make the tree grow call the budget's pressure callback when
+ * needed: it may delete entries from any tree, this one included, but must
+ * not insert any, nor change the trees' settings.
+ * Returns 0 if successful, -1 otherwise.
+ */
+int intSetBudget(AVLIntTree *tree, AVLMemBudget *budget) {
+    if (tree == NULL) return -1;  // Sanity check.
+    memBudgetRelease(tree->_budget, tree->memUsed);
+    memBudgetForce(budget, tree->memUsed);
+    tree->_budget = budget;
+    return 0;
+}
+
+/* Gives the tree a buffer for the given number of entries, or removes it if
+ * the capacity is zero. Insertions go to the buffer, which is kept sorted,
+ * and move to the tree all together when it's full, or when something that
+ * modifies the tree needs them to be there; searches and deletions look into
+ * it too.
+ * Visits, samplings, aggregates, and searches for nodes only read the tree,
+ * so they can run concurrently, and don't flush the buffer: visits, samplings
+ * and aggregates fail while it holds entries, so call intFlushBuffer first
+ * (which, like insertions, needs exclusive access to the tree).
+ * Any entries already buffered are flushed first.
+ * Returns 0 if successful, -1 if memory could not be allocated or the tree's
+ * budget refused it.
+ */
+int intSetBuffer(AVLIntTree *tree, unsigned long int capacity) {
+    if (tree == NULL) return -1;  // Sanity check.
+    if (intFlushBuffer(tree) != 0) return -1;
+    int *newKeys = NULL;
+    void **newData = NULL;
+    if (capacity > 0) {
+        if (_intCharge(tree, capacity * (sizeof(int) + sizeof(void *)), 0) !=
+            0) return -1;
+        newKeys = (int *) calloc(capacity, sizeof(int));
+        newData = (void **) calloc(capacity, sizeof(void *));
+        if ((newKeys == NULL) || (newData == NULL)) {
+            free(newKeys);
+            free(newData);
+            _intRelease(tree, capacity * (sizeof(int) + sizeof(void *)));
+            return -1;
+        }
+    }
+    _intRelease(tree, tree->_bufCapacity * (sizeof(int) + sizeof(void *)));
+    free(tree->_bufKeys);
+    free(tree->_bufData);
+    tree->_bufKeys = newKeys;
+    tree->_bufData = newData;
+    tree->_bufCapacity = capacity;
+    return 0;
+}
+
+/* Moves all the buffered entries into the tree, in order, each one starting
+ * from the place of the previous one.
+ * Returns 0 if successful, -1 if memory could not be allocated for some of
+ * them, or the budget refused the growth of the tree's index, in which case
+ * they are left in the buffer.
+ */
+int intFlushBuffer(AVLIntTree *tree) {
+    if (tree == NULL) return -1;  // Sanity check.
+    if (_intIndexReserve(tree, tree->_buffered) != 0) return -1;
+    AVLIntNode *last = NULL;
+    for (unsigned long int i = 0; i < tree->_buffered; i++) {
+        last = _intTreeInsert(tree, last, tree->_bufKeys[i],
+                              tree->_bufData[i]);
+        if (last == NULL) {
+            _intBufferRemove(tree, 0, i);
+            return -1;
+        }
+    }
+    tree->_buffered = 0;
+    return 0;
+}
+
+/* Performs a depth-first search of the tree like intDFS, splitting the work
+ * among the workers of the given pool.
+ * Every subtree bigger than the pool's grain has its left son visited by a
+ * new task, and each task writes directly into its own portion of the result
+ * array, found using the subtree sizes stored in the nodes.
+ * Options and types are the same accepted by intDFS. If the pool is NULL, this
+ * is just intDFS.
+ * Remember to free the returned array afterwards!
+ */
+void **intParallelDFS(AVLIntTree *tree, int type, int opts,
+                      AVLWorkPool *pool) {
+    // Sanity check for the input arguments.
+    if ((type <= 0) || (opts <= 0)) return NULL;
+    // Buffered entries can't be visited: they must be flushed first.
+    if ((tree != NULL) && (tree->_buffered > 0)) return NULL;
+    if ((tree == NULL) || (tree->_root == NULL)) return NULL;
+    if (pool == NULL) return intDFS(tree, type, opts);
+    AVLIntParVisit visit;
+    if (type & DFS_PRE_ORDER) {
+        visit._type = DFS_PRE_ORDER;
+    } else if (type & DFS_IN_ORDER) {
+        visit._type = DFS_IN_ORDER;
+    } else if (type & DFS_POST_ORDER) {
+        visit._type = DFS_POST_ORDER;
+    } else return NULL;  // Invalid type.
+    // Allocate memory according to options.
+    visit._res = _intAllocVisit(tree->nodesCount, opts, &(visit._intOpt));
+    if (visit._res == NULL) return NULL;
+    visit._grain = pool->grain;
+    AVLIntParStep step = {&visit, tree->_root, 0};
+    workPoolRun(pool, _intParDFS, &step);
+    return (void **) (visit._res);
+}
+
+/* Performs a breadth-first search of the tree like intBFS, splitting the work
+ * among the workers of the given pool.
+ * The tree is cut at a depth that gives enough subtrees to keep all workers
+ * busy. Each subtree's nodes on each level are counted first, then the offsets
+ * at which each subtree must write its nodes on every level are computed, and
+ * at last the subtrees are visited again writing the results. Since a
+ * depth-first visit meets the nodes of a same level in the order in which a
+ * breadth-first one would, no queue is needed.
+ * Options and types are the same accepted by intBFS. If the pool is NULL, this
+ * is just intBFS.
+ * The subtrees and the offsets are charged to the tree's budget, if it has
+ * one, while the visit runs: the visit fails if the budget refuses them.
+ * Remember to free the returned array afterwards!
+ */
+void **intParallelBFS(AVLIntTree *tree, int type, int opts,
+                      AVLWorkPool *pool) {
+    // Buffered entries can't be visited: they must be flushed first.
+    if ((tree != NULL) && (tree->_buffered > 0)) return NULL;
+    // Sanity check on input arguments.
+    if ((tree == NULL) || (tree->_root == NULL) ||
+        (type <= 0) || (opts <= 0) ||
+        !((type & BFS_LEFT_FIRST) || (type & BFS_RIGHT_FIRST)) ||
+        !((opts & SEARCH_KEYS) || (opts & SEARCH_DATA) ||
+        (opts & SEARCH_NODES))) return NULL;
+    if (pool == NULL) return intBFS(tree, type, opts);
+    AVLIntParVisit visit;
+    visit._type = (type & BFS_LEFT_FIRST) ? BFS_LEFT_FIRST : BFS_RIGHT_FIRST;
+    visit._res = _intAllocVisit(tree->nodesCount, opts, &(visit._intOpt));
+    if (visit._res == NULL) return NULL;
+    visit._cutDepth = _intCutDepth(tree->_root->_height, pool->nthreads);
+    visit._levels = tree->_root->_height + 1;
+    unsigned long int scratch = (1UL << visit._cutDepth) *
+                                sizeof(AVLIntNode *) +
+                                ((1UL << visit._cutDepth) + 1) *
+                                visit._levels * sizeof(unsigned long int);
+    if (_intCharge(tree, scratch, 1) != 0) {
+        free(visit._res);
+        return NULL;
+    }
+    visit._roots = calloc(1UL << visit._cutDepth, sizeof(AVLIntNode *));
+    visit._offsets = calloc(((1UL << visit._cutDepth) + 1) * visit._levels,
+                            sizeof(unsigned long int));
+    if ((visit._roots == NULL) || (visit._offsets == NULL)) {
+        free(visit._roots);
+        free(visit._offsets);
+        free(visit._res);
+        _intRelease(tree, scratch);
+        return NULL;
+    }
+    // Collect the subtrees and count the nodes on each level.
+    visit._nTasks = 0;
+    visit._store = 0;
+    _intParBFSSplit(&visit, tree->_root, 0);
+    _intLevelVisit(&visit, tree->_root, 0, 0);
+    workPoolFor(pool, _intParBFSTask, &visit, visit._nTasks);
+    // Turn the counters into write cursors: levels come one after the other,
+    // and on each level the top of the tree comes before the subtrees, which
+    // are sorted as the visit requires.
+    unsigned long int next = 0, count;
+    for (int level = 0; level < visit._levels; level++) {
+        for (unsigned long int row = 0; row <= visit._nTasks; row++) {
+            count = visit._offsets[row * visit._levels + level];
+            visit._offsets[row * visit._levels + level] = next;
+            next += count;
+        }
+    }
+    // Visit everything again, this time storing the results.
+    visit._store = 1;
+    _intLevelVisit(&visit, tree->_root, 0, 0);
+    workPoolFor(pool, _intParBFSTask, &visit, visit._nTasks);
+    free(visit._roots);
+    free(visit._offsets);
+    _intRelease(tree, scratch);
+    return (void **) (visit._res);
+}
+
+/* Builds a new tree from arrays of keys and data, which don't need to be
+ * sorted, splitting the work among the workers of the given pool.
+ * The entries are sorted with a parallel radix sort, then the tree is built
+ * perfectly balanced, with every subtree bigger than the pool's grain having
+ * its left son built by a new task.
+ * Data can be NULL, in which case all entries will have NULL data. If the pool
+ * is NULL, everything is done sequentially.
+ * Returns the new tree, or NULL if memory could not be allocated.
+ */
+AVLIntTree *intBuildParallel(int *keys, void **data, unsigned long int n,
+                             AVLWorkPool *pool) {
+    // Sanity check on input arguments.
+    if ((keys == NULL) && (n > 0)) return NULL;
+    AVLIntTree *newTree = createIntTree();
+    if ((newTree == NULL) || (n == 0)) return newTree;
+    AVLIntParBuild build;
+    build._keys = keys;
+    build._data = data;
+    build._n = n;
+    build._nChunks = 1;
+    if ((pool != NULL) && ((unsigned long int) pool->nthreads > 1))
+        build._nChunks = ((unsigned long int) pool->nthreads < n) ?
+                         (unsigned long int) pool->nthreads : n;
+    build._grain = (pool != NULL) ? pool->grain : ULONG_MAX;
+    build._failed = 0;
+    build._pairs = (AVLIntPair *) calloc(n, sizeof(AVLIntPair));
+    build._tmp = (AVLIntPair *) calloc(n, sizeof(AVLIntPair));
+    build._counts = (unsigned long int *) calloc(
+            build._nChunks * RADIX_BUCKETS, sizeof(unsigned long int));
+    if ((build._pairs == NULL) || (build._tmp == NULL) ||
+        (build._counts == NULL)) {
+        free(build._pairs);
+        free(build._tmp);
+        free(build._counts);
+        free(newTree);
+        return NULL;
+    }
+    // Sort the entries, skipping the passes in which all keys have the same
+    // digit.
+    workPoolFor(pool, _intParLoadTask, &build, build._nChunks);
+    AVLIntPair *swap;
+    unsigned long int next, start, count;
+    int singleDigit;
+    for (build._shift = 0; build._shift < (int) (sizeof(int) * CHAR_BIT);
+         build._shift += RADIX_BITS) {
+        workPoolFor(pool, _intParCountTask, &build, build._nChunks);
+        // Turn the counters into write cursors: digits come one after the
+        // other, and for each digit the chunks keep their order so that the
+        // sort is stable.
+        next = 0;
+        singleDigit = 0;
+        for (int digit = 0; digit < RADIX_BUCKETS; digit++) {
+            start = next;
+            for (unsigned long int chunk = 0; chunk < build._nChunks;
+                 chunk++) {
+                count = build._counts[chunk * RADIX_BUCKETS + digit];
+                build._counts[chunk * RADIX_BUCKETS + digit] = next;
+                next += count;
+            }
+            if (next - start == n) singleDigit = 1;
+        }
+        if (singleDigit) continue;  // Nothing would move.
+        workPoolFor(pool, _intParScatterTask, &build, build._nChunks);
+        swap = build._pairs;
+        build._pairs = build._tmp;
+        build._tmp = swap;
+    }
+    free(build._tmp);
+    free(build._counts);
+    // Build the tree.
+    AVLIntBuildStep step = {&build, NULL, &(newTree->_root), 0, n};
+    workPoolRun(pool, _intParBuild, &step);
+    free(build._pairs);
+    if (build._failed) {
+        _intFreeSubtree(newTree->_root);
+        free(newTree);
+        return NULL;
+    }
+    newTree->nodesCount = n;
+    newTree->memUsed += n * ENTRY_BYTES(newTree);
+    newTree->_minNode = _intTraverseFirst(newTree->_root, DFS_IN_ORDER);
+    newTree->_maxNode = _intMaxKeySon(newTree->_root);
+    return newTree;
+}
+
+/* Calls the given function on each entry of the tree, passing it the key, the
+ * data and the specified context, splitting the work among the workers of the
+ * given pool.
+ * Every subtree bigger than the pool's grain has its left son visited by a
+ * new task, so calls can happen concurrently and in any order. If the pool is
+ * NULL, the entries are visited sequentially, in order.
+ * Returns 0 if successful, -1 otherwise.
+ */
+int intParallelForEach(AVLIntTree *tree,
+                       void (*fn)(int key, void *data, void *ctx),
+                       void *ctx, AVLWorkPool *pool) {
+    // Sanity check on input arguments.
+    if ((tree == NULL) || (fn == NULL)) return -1;
+    if (tree->_buffered > 0) return -1;  // They must be flushed first.
+    AVLIntParFold fold = {fn, NULL, NULL, NULL, ctx,
+                          (pool != NULL) ? pool->grain : ULONG_MAX};
+    AVLIntFoldStep step = {&fold, tree->_root, NULL};
+    workPoolRun(pool, _intParFold, &step);
+    return 0;
+}
+
+/* Reduces the entries of the tree to a single value, splitting the work among
+ * the workers of the given pool.
+ * Starting from the identity value, the reduce function adds an entry to an
+ * accumulated value and returns the result, while the combine function merges
+ * two accumulated values into one. Subtrees are reduced by different tasks,
+ * then partial results are combined following the order of the keys, so the
+ * combine function needs to be associative but not commutative, and the
+ * identity must be neutral for it. If the pool is NULL, the entries are just
+ * reduced sequentially.
+ * Returns the reduced value, which is the identity for an empty tree.
+ */
+void *intParallelReduce(AVLIntTree *tree,
+                        void *(*reduce)(void *acc, int key, void *data,
+                                        void *ctx),
+                        void *(*combine)(void *acc1, void *acc2, void *ctx),
+                        void *identity, void *ctx, AVLWorkPool *pool) {
+    // Sanity check on input arguments.
+    if ((tree == NULL) || (reduce == NULL) || (combine == NULL) ||
+        (tree->_buffered > 0)) return identity;
+    AVLIntParFold fold = {NULL, reduce, combine, identity, ctx,
+                          (pool != NULL) ? pool->grain : ULONG_MAX};
+    AVLIntFoldStep step = {&fold, tree->_root, identity};
+    workPoolRun(pool, _intParFold, &step);
+    return step._acc;
+}
+
 // INTERNAL LIBRARY SUBROUTINES //
 /* Creates a new AVL node in the heap. Requires an integer key and some data. */
-AVLIntNode *_createIntNode(int newKey, void *newData) {
-    AVLIntNode *newNode = (AVLIntNode *) malloc(sizeof(AVLIntNode));
+AVLIntNode *_createIntNode(int newKey, void *newData,
+                           unsigned long int augSize) {
+    AVLIntNode *newNode = (AVLIntNode *) malloc(sizeof(AVLIntNode) + augSize);
     if (newNode == NULL) return NULL;
     newNode->_father = NULL;
     newNode->_leftSon = NULL;
     newNode->_rightSon = NULL;
+    newNode->_newer = NULL;
+    newNode->_older = NULL;
     newNode->_key = newKey;
     newNode->_data = newData;
     newNode->_height = 0;
+    newNode->_size = 1;
     return newNode;
 }
 
@@ -358,19 +1539,538 @@ AVLIntNode *_intMaxKeySon(AVLIntNode *node) {
     return curr;
 }
 
+/* Returns the node that precedes a given one in an in-order visit, or NULL if
+ * it's the first one.
+ */
+AVLIntNode *_intPrevNode(AVLIntNode *node) {
+    // Go to the left subtree, or up to the first father on the left.
+    if (node->_leftSon != NULL) return _intMaxKeySon(node->_leftSon);
+    AVLIntNode *curr = node;
+    AVLIntNode *father = curr->_father;
+    while ((father != NULL) && (father->_leftSon == curr)) {
+        curr = father;
+        father = curr->_father;
+    }
+    return father;
+}
+
 /* Returns a pointer to the node with the specified key, or NULL. */
 AVLIntNode *_searchIntNode(AVLIntTree *tree, int key) {
     if (tree->_root == NULL) return NULL;
-    AVLIntNode *curr = tree->_root;
+    if (tree->_index != NULL) return _intIndexLookup(tree, key);
+    AVLIntNode *curr;
+    AVLIntNode **slot = NULL;
+    // Look into the cache first, if there's one.
+    if (tree->_cache != NULL) {
+        slot = tree->_cache + _intCacheSlot(tree, key);
+        curr = __atomic_load_n(slot, __ATOMIC_RELAXED);
+        if ((curr != NULL) && (curr->_key == key)) {
+            __atomic_add_fetch(&(tree->cacheHits), 1, __ATOMIC_RELAXED);
+            return curr;
+        }
+        __atomic_add_fetch(&(tree->cacheMisses), 1, __ATOMIC_RELAXED);
+    }
+    curr = tree->_root;
     int comp;
     while (curr != NULL) {
-        comp = curr->_key - key;
+        comp = COMPARE(curr->_key, key);
         if (comp > 0) {
             curr = curr->_leftSon;
         } else if (comp < 0) {
             curr = curr->_rightSon;
-        } else return curr;
-    }
+        } else {
+            if (slot != NULL) __atomic_store_n(slot, curr, __ATOMIC_RELAXED);
+            return curr;
+        }
+    }
+    return NULL;
+}
+
+/* Returns the node from which a key has to be looked for, or inserted, given
+ * a node of the tree to start from: the root of the smallest subtree above it
+ * that can hold the key, or the last node before or after that subtree if the
+ * key lies just outside of it.
+ * The finger's subtree is widened by climbing towards the root, keeping track
+ * of its leftmost or rightmost node (depending on which side the key is).
+ * Climbing from a son on the key's side only widens the subtree on the other
+ * side, so that node stays the same and no other one has to be looked at.
+ */
+AVLIntNode *_intFingerStart(AVLIntNode *finger, int key) {
+    AVLIntNode *curr = finger;
+    AVLIntNode *father, *last;
+    if (COMPARE(finger->_key, key) < 0) {
+        // The key comes after the finger.
+        last = _intMaxKeySon(finger);
+        while (COMPARE(last->_key, key) < 0) {
+            father = curr->_father;
+            if (father == NULL) return last;
+            if (father->_leftSon == curr) {
+                if (COMPARE(father->_key, key) > 0) return last;
+                last = father->_rightSon != NULL ?
+                       _intMaxKeySon(father->_rightSon) : father;
+            }
+            curr = father;
+        }
+    } else {
+        // The key comes before the finger, or is the same.
+        last = finger;
+        while (last->_leftSon != NULL) last = last->_leftSon;
+        while (COMPARE(last->_key, key) > 0) {
+            father = curr->_father;
+            if (father == NULL) return last;
+            if (father->_rightSon == curr) {
+                if (COMPARE(father->_key, key) < 0) return last;
+                last = father;
+                while (last->_leftSon != NULL) last = last->_leftSon;
+            }
+            curr = father;
+        }
+    }
+    return curr;
+}
+
+/* Returns a pointer to the node with the specified key, or NULL, starting the
+ * search from a given node of the tree.
+ */
+AVLIntNode *_intFingerSearch(AVLIntNode *finger, int key) {
+    AVLIntNode *curr = _intFingerStart(finger, key);
+    int comp;
+    while (curr != NULL) {
+        comp = COMPARE(curr->_key, key);
+        if (comp > 0) {
+            curr = curr->_leftSon;
+        } else if (comp < 0) {
+            curr = curr->_rightSon;
+        } else return curr;
+    }
+    return NULL;
+}
+
+/* Returns a random position in a sequence of n > 0 elements, each with the
+ * same probability, drawn with nrand48 using the given state.
+ * Draws that would favor some positions over others are discarded.
+ */
+unsigned long int _intRandomRank(unsigned short rng[3], unsigned long int n) {
+    // nrand48 gives 31 random bits: use two draws if they are not enough.
+    int wide = n > (1UL << 31);
+    unsigned long int range = wide ? (1UL << 62) : (1UL << 31);
+    unsigned long int bound = range - range % n;
+    unsigned long int draw;
+    do {
+        draw = (unsigned long int) nrand48(rng);
+        if (wide) draw = (draw << 31) | (unsigned long int) nrand48(rng);
+    } while (draw >= bound);
+    return draw % n;
+}
+
+/* Returns the node in the given position of an in-order visit of a subtree,
+ * counting from 0, or NULL if the subtree isn't that big.
+ */
+AVLIntNode *_intSelectNode(AVLIntNode *node, unsigned long int rank) {
+    AVLIntNode *curr = node;
+    unsigned long int leftSize;
+    while (curr != NULL) {
+        leftSize = _intSize(curr->_leftSon);
+        if (rank < leftSize) {
+            curr = curr->_leftSon;
+        } else if (rank > leftSize) {
+            rank -= leftSize + 1;
+            curr = curr->_rightSon;
+        } else return curr;
+    }
+    return NULL;
+}
+
+/* Compares two positions, for qsort. */
+int _intCompareRanks(const void *rank1, const void *rank2) {
+    unsigned long int r1 = *((const unsigned long int *) rank1);
+    unsigned long int r2 = *((const unsigned long int *) rank2);
+    return COMPARE(r1, r2);
+}
+
+/* Creates and inserts a new node in the tree, leaving the counter as it is.
+ * Its place is looked for starting from the given node if it's not NULL,
+ * otherwise from the root.
+ * Returns the new node, or NULL if memory could not be allocated.
+ */
+AVLIntNode *_intTreeInsert(AVLIntTree *tree, AVLIntNode *finger, int newKey,
+                           void *newData) {
+    AVLIntNode *newNode = _createIntNode(newKey, newData,
+                                         tree->_augment.augSize);
+    if (newNode == NULL) return NULL;
+    if (_intIndexAdd(tree, newNode) != 0) {
+        _deleteIntNode(newNode);
+        return NULL;
+    }
+    if (tree->_augment.augSize > 0) _intUpdateAugment(tree, newNode);
+    if (tree->_evictPolicy & EVICT_LRU) _intUseNode(tree, newNode);
+    if (tree->_root == NULL) {
+        // The tree is empty.
+        tree->_root = newNode;
+        tree->_minNode = newNode;
+        tree->_maxNode = newNode;
+        return newNode;
+    }
+    // Look for the correct position and place it there.
+    AVLIntNode *curr = tree->_root;
+    if (finger != NULL) curr = _intFingerStart(finger, newKey);
+    AVLIntNode *pred = NULL;
+    int comp;
+    while (curr != NULL) {
+        pred = curr;
+        comp = COMPARE(curr->_key, newKey);
+        if (comp >= 0) {
+            // Equals are kept in the left subtree.
+            curr = curr->_leftSon;
+        } else {
+            curr = curr->_rightSon;
+        }
+    }
+    comp = COMPARE(pred->_key, newKey);
+    if (comp >= 0) {
+        _intInsertAsLeftSubtree(pred, newNode);
+        // A new leaf comes first only if it hangs from the first node.
+        if (pred == tree->_minNode) tree->_minNode = newNode;
+    } else {
+        _intInsertAsRightSubtree(pred, newNode);
+        if (pred == tree->_maxNode) tree->_maxNode = newNode;
+    }
+    _intBalanceInsert(tree, newNode);
+    return newNode;
+}
+
+/* Stores in the given arrays, either of which can be NULL, up to k entries
+ * with the greatest or the smallest keys, in order, walking from the rightmost
+ * or leftmost node while merging in the buffered entries, which are sorted
+ * too.
+ * Returns the number of entries stored.
+ */
+unsigned long int _intTakeExtremes(AVLIntTree *tree, unsigned long int k,
+                                   int *keys, void **data, int largest) {
+    AVLIntNode *node = largest ? tree->_maxNode : tree->_minNode;
+    // Buffered entries are taken from the end they are needed from.
+    unsigned long int left = tree->_buffered, taken = 0, pos;
+    int fromBuffer;
+    while ((taken < k) && ((node != NULL) || (left > 0))) {
+        pos = largest ? left - 1 : tree->_buffered - left;
+        if (left == 0) {
+            fromBuffer = 0;
+        } else if (node == NULL) {
+            fromBuffer = 1;
+        } else fromBuffer = largest ? (tree->_bufKeys[pos] > node->_key) :
+                            (tree->_bufKeys[pos] < node->_key);
+        if (fromBuffer) {
+            if (keys != NULL) keys[taken] = tree->_bufKeys[pos];
+            if (data != NULL) data[taken] = tree->_bufData[pos];
+            left--;
+        } else {
+            if (keys != NULL) keys[taken] = node->_key;
+            if (data != NULL) data[taken] = node->_data;
+            node = largest ? _intPrevNode(node) :
+                   _intTraverseNext(tree->_root, node, DFS_IN_ORDER, NULL);
+        }
+        taken++;
+    }
+    return taken;
+}
+
+/* Removes the entry with the greatest or the smallest key, looking both at the
+ * tree's extreme node and at the buffer's end, storing its key and data where
+ * given.
+ * Returns 1 if an entry was removed, 0 if there's none.
+ */
+int _intPopExtreme(AVLIntTree *tree, int *key, void **data, int largest) {
+    AVLIntNode *node = largest ? tree->_maxNode : tree->_minNode;
+    unsigned long int pos = largest ? tree->_buffered - 1 : 0;
+    if ((tree->_buffered > 0) &&
+        ((node == NULL) || (largest ? (tree->_bufKeys[pos] > node->_key) :
+                            (tree->_bufKeys[pos] < node->_key)))) {
+        if (key != NULL) *key = tree->_bufKeys[pos];
+        if (data != NULL) *data = tree->_bufData[pos];
+        _intBufferRemove(tree, pos, 1);
+        _intRelease(tree, ENTRY_BYTES(tree));
+        tree->nodesCount--;
+        return 1;
+    }
+    if (node == NULL) return 0;  // The tree is empty.
+    if (key != NULL) *key = node->_key;
+    if (data != NULL) *data = node->_data;
+    return intDeleteNode(tree, node, 0);
+}
+
+/* Returns the position of the first buffered entry with a key not less than
+ * the given one, or the number of buffered entries if there's none.
+ */
+unsigned long int _intBufferSearch(AVLIntTree *tree, int key) {
+    unsigned long int lo = 0, hi = tree->_buffered, mid;
+    while (lo < hi) {
+        mid = lo + (hi - lo) / 2;
+        if (tree->_bufKeys[mid] < key) {
+            lo = mid + 1;
+        } else hi = mid;
+    }
+    return lo;
+}
+
+/* Adds an entry to the buffer, after those with the same key. The buffer must
+ * not be full.
+ */
+void _intBufferInsert(AVLIntTree *tree, int newKey, void *newData) {
+    unsigned long int lo = 0, hi = tree->_buffered, mid;
+    while (lo < hi) {
+        mid = lo + (hi - lo) / 2;
+        if (tree->_bufKeys[mid] <= newKey) {
+            lo = mid + 1;
+        } else hi = mid;
+    }
+    memmove(tree->_bufKeys + lo + 1, tree->_bufKeys + lo,
+            (tree->_buffered - lo) * sizeof(int));
+    memmove(tree->_bufData + lo + 1, tree->_bufData + lo,
+            (tree->_buffered - lo) * sizeof(void *));
+    tree->_bufKeys[lo] = newKey;
+    tree->_bufData[lo] = newData;
+    tree->_buffered++;
+}
+
+/* Removes a number of consecutive entries from the buffer, starting from the
+ * given position.
+ */
+void _intBufferRemove(AVLIntTree *tree, unsigned long int pos,
+                      unsigned long int count) {
+    memmove(tree->_bufKeys + pos, tree->_bufKeys + pos + count,
+            (tree->_buffered - pos - count) * sizeof(int));
+    memmove(tree->_bufData + pos, tree->_bufData + pos + count,
+            (tree->_buffered - pos - count) * sizeof(void *));
+    tree->_buffered -= count;
+}
+
+/* Drops the buffered entries, eventually freeing their data, and the buffer
+ * itself.
+ */
+void _intFreeBuffer(AVLIntTree *tree, int opts) {
+    if (opts & DELETE_FREE_DATA)
+        for (unsigned long int i = 0; i < tree->_buffered; i++)
+            free(tree->_bufData[i]);
+    tree->nodesCount -= tree->_buffered;
+    tree->_buffered = 0;
+    tree->_bufCapacity = 0;
+    free(tree->_bufKeys);
+    free(tree->_bufData);
+    tree->_bufKeys = NULL;
+    tree->_bufData = NULL;
+}
+
+/* Evicts an entry from the tree, as its policy says. Buffered entries are
+ * moved into the tree first, to be considered too.
+ * Returns 0 if successful, -1 if there's no policy, nothing to evict, or
+ * buffered entries could not be moved into the tree.
+ */
+int _intEvict(AVLIntTree *tree) {
+    AVLIntNode *victim;
+    if (tree->_evictPolicy == 0) return -1;
+    if (intFlushBuffer(tree) != 0) return -1;
+    if (tree->_evictPolicy & EVICT_MIN_KEY) {
+        victim = tree->_minNode;
+    } else if (tree->_evictPolicy & EVICT_MAX_KEY) {
+        victim = tree->_maxNode;
+    } else victim = tree->_oldest;
+    if (victim == NULL) return -1;
+    intDeleteNode(tree, victim, tree->_evictOpts);
+    return 0;
+}
+
+/* Makes a node the most recently used one, moving it to the front of the
+ * list, or adding it there if it's not in the list yet.
+ */
+void _intUseNode(AVLIntTree *tree, AVLIntNode *node) {
+    if (tree->_newest == node) return;
+    // Only the newest node has no newer one.
+    if (node->_newer != NULL) {
+        node->_newer->_older = node->_older;
+        if (node->_older != NULL) {
+            node->_older->_newer = node->_newer;
+        } else tree->_oldest = node->_newer;
+    }
+    node->_newer = NULL;
+    node->_older = tree->_newest;
+    if (tree->_newest != NULL) tree->_newest->_newer = node;
+    tree->_newest = node;
+    if (tree->_oldest == NULL) tree->_oldest = node;
+}
+
+/* Removes a node from the list of the most recently used ones. */
+void _intForgetUse(AVLIntTree *tree, AVLIntNode *node) {
+    if (node->_newer != NULL) {
+        node->_newer->_older = node->_older;
+    } else if (tree->_newest == node) tree->_newest = node->_older;
+    if (node->_older != NULL) {
+        node->_older->_newer = node->_newer;
+    } else if (tree->_oldest == node) tree->_oldest = node->_newer;
+    node->_newer = NULL;
+    node->_older = NULL;
+}
+
+/* Adds the given number of bytes to the memory used by the tree, charging them
+ * to its budget, if it has one. The charge is quiet, without the pressure
+ * callback, when the tree is in the middle of a visit or a modification that
+ * the callback must not disturb.
+ * The count is updated atomically, since concurrent visits charge it too.
+ * Returns 0 if successful, -1 if the budget refused them.
+ */
+int _intCharge(AVLIntTree *tree, unsigned long int bytes, int quiet) {
+    if (quiet) {
+        if (memBudgetTryCharge(tree->_budget, bytes) != 0) return -1;
+    } else if (memBudgetCharge(tree->_budget, bytes) != 0) return -1;
+    __atomic_add_fetch(&(tree->memUsed), bytes, __ATOMIC_RELAXED);
+    return 0;
+}
+
+/* Removes the given number of bytes from the memory used by the tree, giving
+ * them back to its budget, if it has one.
+ */
+void _intRelease(AVLIntTree *tree, unsigned long int bytes) {
+    memBudgetRelease(tree->_budget, bytes);
+    __atomic_sub_fetch(&(tree->memUsed), bytes, __ATOMIC_RELAXED);
+}
+
+/* Returns the cache slot of a given key, by Fibonacci hashing. */
+unsigned long int _intCacheSlot(AVLIntTree *tree, int key) {
+    return (unsigned long int) (((unsigned int) key * 2654435769U) >>
+                                (32 - tree->_cacheBits));
+}
+
+/* Removes a node that is being deleted from the cache. Since nodes keep their
+ * keys, it can only be in the slot of its own key.
+ */
+void _intCacheForget(AVLIntTree *tree, AVLIntNode *node) {
+    if (tree->_cache == NULL) return;
+    AVLIntNode **slot = tree->_cache + _intCacheSlot(tree, node->_key);
+    if (*slot == node) *slot = NULL;
+}
+
+/* Returns the slot of a hash index in which the search for a key starts, by
+ * Fibonacci hashing.
+ */
+unsigned long int _intIndexHome(int bits, int key) {
+    return (unsigned long int) (((unsigned long long int) (unsigned int) key *
+                                 11400714819323198485ULL) >> (64 - bits));
+}
+
+/* Stores a node in the first free slot of a hash index, starting from its
+ * key's home slot. The index must have a free slot.
+ */
+void _intIndexPut(AVLIntIndexSlot *index, int bits, AVLIntNode *node) {
+    unsigned long int mask = (1UL << bits) - 1;
+    unsigned long int pos = _intIndexHome(bits, node->_key);
+    while (index[pos]._node != NULL) pos = (pos + 1) & mask;
+    index[pos]._node = node;
+    index[pos]._key = node->_key;
+}
+
+/* Stores all the nodes of a subtree in a hash index. */
+void _intIndexFill(AVLIntIndexSlot *index, int bits, AVLIntNode *node) {
+    while (node != NULL) {
+        _intIndexFill(index, bits, node->_leftSon);
+        _intIndexPut(index, bits, node);
+        node = node->_rightSon;
+    }
+}
+
+/* Replaces the tree's hash index with a new one with the given number of slots
+ * (as a power of two), holding all the nodes of the tree, and charges it to
+ * the tree's budget, quietly if asked to.
+ * Returns 0 if successful, -1 if memory could not be allocated or the budget
+ * refused it.
+ */
+int _intIndexResize(AVLIntTree *tree, int bits, int quiet) {
+    if (bits >= (int) (sizeof(unsigned long int) * CHAR_BIT) - 1) return -1;
+    unsigned long int bytes = (1UL << bits) * sizeof(AVLIntIndexSlot);
+    if (_intCharge(tree, bytes, quiet) != 0) return -1;
+    AVLIntIndexSlot *newIndex = (AVLIntIndexSlot *) calloc(
+            1UL << bits, sizeof(AVLIntIndexSlot));
+    if (newIndex == NULL) {
+        _intRelease(tree, bytes);
+        return -1;
+    }
+    _intIndexFill(newIndex, bits, tree->_root);
+    _intRelease(tree, intIndexMemory(tree));
+    free(tree->_index);
+    tree->_index = newIndex;
+    tree->_indexBits = bits;
+    tree->_indexUsed = _intSize(tree->_root);
+    return 0;
+}
+
+/* Grows the tree's hash index, if there's one, so that the given number of
+ * nodes can be added to it without growing it again, while nothing is being
+ * held that the pressure callback of the tree's budget could evict.
+ * Returns 0 if successful, -1 if memory could not be allocated or the budget
+ * refused it.
+ */
+int _intIndexReserve(AVLIntTree *tree, unsigned long int count) {
+    if (tree->_index == NULL) return 0;
+    int bits = tree->_indexBits;
+    while ((bits < (int) (sizeof(unsigned long int) * CHAR_BIT) - 1) &&
+           (((tree->_indexUsed + count) << INDEX_LOAD_SHIFT) > (1UL << bits)))
+        bits++;
+    if (bits == tree->_indexBits) return 0;
+    return _intIndexResize(tree, bits, 0);
+}
+
+/* Adds a node that is being inserted to the tree's hash index, if there's
+ * one, which grows if needed, charging the growth quietly to the tree's budget.
+ * Returns 0 if successful, -1 if memory could not be allocated or the budget
+ * refused it.
+ */
+int _intIndexAdd(AVLIntTree *tree, AVLIntNode *node) {
+    if (tree->_index == NULL) return 0;
+    if (((tree->_indexUsed + 1) << INDEX_LOAD_SHIFT) >
+        (1UL << tree->_indexBits)) {
+        if (_intIndexResize(tree, tree->_indexBits + 1, 1) != 0) return -1;
+    }
+    _intIndexPut(tree->_index, tree->_indexBits, node);
+    tree->_indexUsed++;
+    return 0;
+}
+
+/* Removes a node that is being deleted from the tree's hash index, if there's
+ * one. The nodes that follow it in its probe sequence are shifted back, so
+ * that no searches get lost and there's no need for tombstones.
+ */
+void _intIndexRemove(AVLIntTree *tree, AVLIntNode *node) {
+    if (tree->_index == NULL) return;
+    AVLIntIndexSlot *index = tree->_index;
+    unsigned long int mask = (1UL << tree->_indexBits) - 1;
+    unsigned long int hole = _intIndexHome(tree->_indexBits, node->_key);
+    unsigned long int next, home;
+    while (index[hole]._node != node) hole = (hole + 1) & mask;
+    next = hole;
+    for (;;) {
+        next = (next + 1) & mask;
+        if (index[next]._node == NULL) break;
+        // Move the node into the hole, unless its home slot comes after the
+        // hole, where it would then be unreachable.
+        home = _intIndexHome(tree->_indexBits, index[next]._key);
+        if (((next - home) & mask) >= ((next - hole) & mask)) {
+            index[hole] = index[next];
+            hole = next;
+        }
+    }
+    index[hole]._node = NULL;
+    tree->_indexUsed--;
+}
+
+/* Returns a node with the specified key found in the tree's hash index, or
+ * NULL.
+ */
+AVLIntNode *_intIndexLookup(AVLIntTree *tree, int key) {
+    AVLIntIndexSlot *index = tree->_index;
+    unsigned long int mask = (1UL << tree->_indexBits) - 1;
+    unsigned long int pos = _intIndexHome(tree->_indexBits, key);
+    while (index[pos]._node != NULL) {
+        if (index[pos]._key == key) return index[pos]._node;
+        pos = (pos + 1) & mask;
+    }
     return NULL;
 }
 
@@ -382,6 +2082,12 @@ int _intHeight(AVLIntNode *node) {
     return node->_height;
 }
 
+/* Returns the number of nodes in the subtree rooted in a given node. */
+unsigned long int _intSize(AVLIntNode *node) {
+    if (node == NULL) return 0;
+    return node->_size;
+}
+
 /* Sets the height of the specified node to the given value. */
 void _intSetHeight(AVLIntNode *node, int newHeight) {
     if (node != NULL) node->_height = newHeight;
@@ -393,138 +2099,159 @@ int _intBalanceFactor(AVLIntNode *node) {
     return _intHeight(node->_leftSon) - _intHeight(node->_rightSon);
 }
 
-/* Updates the height of a given node. */
-void _intUpdateHeight(AVLIntNode *node) {
+/* Updates the height, the subtree size and the summary, if any, of a given
+ * node.
+ */
+void _intUpdateHeight(AVLIntTree *tree, AVLIntNode *node) {
     if (node != NULL) {
         _intSetHeight(node, MAX(_intHeight(node->_leftSon),
                                 _intHeight(node->_rightSon)) + 1);
+        node->_size = _intSize(node->_leftSon) + _intSize(node->_rightSon) + 1;
+        if (tree->_augment.augSize > 0) _intUpdateAugment(tree, node);
     }
 }
 
-/* Swaps contents between two nodes. */
-void _intSwapInfo(AVLIntNode *node1, AVLIntNode *node2) {
-    int key1 = node1->_key;
-    void *data1 = node1->_data;
-    int key2 = node2->_key;
-    void *data2 = node2->_data;
-    node1->_key = key2;
-    node2->_key = key1;
-    node1->_data = data2;
-    node2->_data = data1;
+/* Recomputes the summary of the subtree rooted in a given node from its entry
+ * and the summaries of its sons.
+ */
+void _intUpdateAugment(AVLIntTree *tree, AVLIntNode *node) {
+    AVLIntAugment *augment = &(tree->_augment);
+    augment->entry(AUGMENT(node), node->_key, node->_data, augment->ctx);
+    if (node->_leftSon != NULL)
+        augment->combine(AUGMENT(node), AUGMENT(node->_leftSon),
+                         AUGMENT(node), augment->ctx);
+    if (node->_rightSon != NULL)
+        augment->combine(AUGMENT(node), AUGMENT(node), AUGMENT(node->_rightSon),
+                         augment->ctx);
+}
+
+/* Puts the subtree rooted in a given node in the place of another node, which
+ * is left detached from its father.
+ */
+void _intReplaceSubtree(AVLIntTree *tree, AVLIntNode *node,
+                        AVLIntNode *newNode) {
+    AVLIntNode *father = node->_father;
+    node->_father = NULL;
+    if (father == NULL) {
+        if (newNode != NULL) newNode->_father = NULL;
+        tree->_root = newNode;
+    } else if (father->_leftSon == node) {
+        _intInsertAsLeftSubtree(father, newNode);
+    } else _intInsertAsRightSubtree(father, newNode);
 }
 
-/* Performs a simple right rotation at the specified node. */
-void _intRightRotation(AVLIntNode *node) {
+/* Performs a simple right rotation at the specified node.
+ * Nodes are relinked rather than having their contents swapped, so that
+ * pointers to them stay valid.
+ */
+void _intRightRotation(AVLIntTree *tree, AVLIntNode *node) {
     AVLIntNode *leftSon = node->_leftSon;
-    // Swap the node and its son's contents to make it climb.
-    _intSwapInfo(node, leftSon);
-    // Shrink the tree portion in subtrees.
-    AVLIntNode *rTree = _intCutRightSubtree(node);
-    AVLIntNode *lTree = _intCutLeftSubtree(node);
-    AVLIntNode *lTree_l = _intCutLeftSubtree(leftSon);
-    AVLIntNode *lTree_r = _intCutRightSubtree(leftSon);
+    // Make the son climb in place of the node.
+    _intReplaceSubtree(tree, node, leftSon);
     // Recombine portions to respect the search property.
-    _intInsertAsRightSubtree(lTree, rTree);
-    _intInsertAsLeftSubtree(lTree, lTree_r);
-    _intInsertAsRightSubtree(node, lTree);
-    _intInsertAsLeftSubtree(node, lTree_l);
+    _intInsertAsLeftSubtree(node, _intCutRightSubtree(leftSon));
+    _intInsertAsRightSubtree(leftSon, node);
     // Update the height of the involved nodes.
-    _intUpdateHeight(node->_rightSon);
-    _intUpdateHeight(node);
+    _intUpdateHeight(tree, node);
+    _intUpdateHeight(tree, leftSon);
 }
 
-/* Performs a simple left rotation at the specified node. */
-void _intLeftRotation(AVLIntNode *node) {
+/* Performs a simple left rotation at the specified node.
+ * Nodes are relinked rather than having their contents swapped, so that
+ * pointers to them stay valid.
+ */
+void _intLeftRotation(AVLIntTree *tree, AVLIntNode *node) {
     AVLIntNode *rightSon = node->_rightSon;
-    // Swap the node and its son's contents to make it climb.
-    _intSwapInfo(node, rightSon);
-    // Shrink the tree portion in subtrees.
-    AVLIntNode *rTree = _intCutRightSubtree(node);
-    AVLIntNode *lTree = _intCutLeftSubtree(node);
-    AVLIntNode *rTree_l = _intCutLeftSubtree(rightSon);
-    AVLIntNode *rTree_r = _intCutRightSubtree(rightSon);
+    // Make the son climb in place of the node.
+    _intReplaceSubtree(tree, node, rightSon);
     // Recombine portions to respect the search property.
-    _intInsertAsLeftSubtree(rTree, lTree);
-    _intInsertAsRightSubtree(rTree, rTree_l);
-    _intInsertAsLeftSubtree(node, rTree);
-    _intInsertAsRightSubtree(node, rTree_r);
+    _intInsertAsRightSubtree(node, _intCutLeftSubtree(rightSon));
+    _intInsertAsLeftSubtree(rightSon, node);
     // Update the height of the involved nodes.
-    _intUpdateHeight(node->_leftSon);
-    _intUpdateHeight(node);
+    _intUpdateHeight(tree, node);
+    _intUpdateHeight(tree, rightSon);
 }
 
-/* Examines the balance factor of a given node and eventually rotates. */
-void _intRotate(AVLIntNode *node) {
+/* Examines the balance factor of a given node and eventually rotates.
+ * Returns the node that is now at the top of the subtree.
+ */
+AVLIntNode *_intRotate(AVLIntTree *tree, AVLIntNode *node) {
     int balFactor = _intBalanceFactor(node);
     if (balFactor == 2) {
         if (_intBalanceFactor(node->_leftSon) >= 0) {
             // LL displacement: rotate right.
-            _intRightRotation(node);
+            _intRightRotation(tree, node);
         } else {
             // LR displacement: apply double rotation.
-            _intLeftRotation(node->_leftSon);
-            _intRightRotation(node);
+            _intLeftRotation(tree, node->_leftSon);
+            _intRightRotation(tree, node);
         }
     } else if (balFactor == -2) {
         if (_intBalanceFactor(node->_rightSon) <= 0) {
             // RR displacement: rotate left.
-            _intLeftRotation(node);
+            _intLeftRotation(tree, node);
         } else {
             // RL displacement: apply double rotation.
-            _intRightRotation(node->_rightSon);
-            _intLeftRotation(node);
+            _intRightRotation(tree, node->_rightSon);
+            _intLeftRotation(tree, node);
         }
-    }
+    } else return node;
+    return node->_father;
 }
 
 /* Updates heights and looks for displacements following an insertion. */
-void _intBalanceInsert(AVLIntNode *newNode) {
+void _intBalanceInsert(AVLIntTree *tree, AVLIntNode *newNode) {
     AVLIntNode *curr = newNode->_father;
     while (curr != NULL) {
         if (abs(_intBalanceFactor(curr)) >= 2) {
-            // Unbalanced node found.
-            break;
-        } else {
-            _intUpdateHeight(curr);
-            curr = curr->_father;
-        }
+            // Unbalanced node found: the rotation restores the height the
+            // subtree had before the insertion, but the sizes of the nodes
+            // above still have to be updated.
+            curr = _intRotate(tree, curr);
+        } else _intUpdateHeight(tree, curr);
+        curr = curr->_father;
     }
-    if (curr != NULL) _intRotate(curr);
 }
 
 /* Updates heights and looks for displacements following a deletion. */
-void _intBalanceDelete(AVLIntNode *remFather) {
+void _intBalanceDelete(AVLIntTree *tree, AVLIntNode *remFather) {
     AVLIntNode *curr = remFather;
     while (curr != NULL) {
         if (abs(_intBalanceFactor(curr)) >= 2) {
             // There may be more than one unbalanced node.
-            _intRotate(curr);
-        } else _intUpdateHeight(curr);
+            curr = _intRotate(tree, curr);
+        } else _intUpdateHeight(tree, curr);
         curr = curr->_father;
     }
 }
 
-/* Cuts a node with a single son. */
-AVLIntNode *_intCutOneSonNode(AVLIntNode *node) {
-    AVLIntNode *son = NULL;
-    AVLIntNode *father = node->_father;
-    if (node->_leftSon != NULL) {
-        son = node->_leftSon;
-    } else if (node->_rightSon != NULL) {
-        son = node->_rightSon;
-    }
-    if (son == NULL) {  // The node is a leaf.
-        son = _intCutSubtree(node);  // Will be returned later.
+/* Removes a node from the tree and rebalances it. If the node has two sons,
+ * its predecessor takes its place. The node keeps its contents and is left
+ * totally disconnected, ready to be freed.
+ */
+void _intDeleteNode(AVLIntTree *tree, AVLIntNode *node) {
+    AVLIntNode *remFather;  // Lowest node that lost a descendant.
+    if ((node->_leftSon == NULL) || (node->_rightSon == NULL)) {
+        // Let the only son, if any, take the place of the node.
+        remFather = node->_father;
+        _intReplaceSubtree(tree, node, (node->_leftSon != NULL) ?
+                                       _intCutLeftSubtree(node) :
+                                       _intCutRightSubtree(node));
     } else {
-        // Swap the content from the son to the father.
-        _intSwapInfo(node, son);
-        // Cut the node and balance the deletion.
-        _intCutSubtree(son);
-        _intInsertAsRightSubtree(node, _intCutSubtree(son->_rightSon));
-        _intInsertAsLeftSubtree(node, _intCutSubtree(son->_leftSon));
+        // Detach the predecessor, then let it take the place of the node.
+        AVLIntNode *maxLeft = _intMaxKeySon(node->_leftSon);
+        remFather = maxLeft->_father;
+        if (remFather == node) {
+            remFather = maxLeft;
+            _intCutLeftSubtree(node);
+        } else {
+            _intReplaceSubtree(tree, maxLeft, _intCutLeftSubtree(maxLeft));
+            _intInsertAsLeftSubtree(maxLeft, _intCutLeftSubtree(node));
+        }
+        _intInsertAsRightSubtree(maxLeft, _intCutRightSubtree(node));
+        _intReplaceSubtree(tree, node, maxLeft);
     }
-    _intBalanceDelete(father);
-    return son;  // Return the node to free, now totally disconnected.
+    _intBalanceDelete(tree, remFather);
 }
 
 /* Performs an in-order, recursive DFS. */
@@ -624,3 +2351,404 @@ void _intPostODFS(AVLIntNode *rootNode, void ***intPtr, int intOpt) {
         **(intPtr) = rootNode->_data;
     }
 }
+
+/* Returns the first node of a visit of the given type of a subtree. */
+AVLIntNode *_intTraverseFirst(AVLIntNode *root, int type) {
+    AVLIntNode *curr = root;
+    if (curr == NULL) return NULL;
+    if (type & DFS_IN_ORDER) {
+        while (curr->_leftSon != NULL) curr = curr->_leftSon;
+    } else if (type & DFS_POST_ORDER) {
+        while ((curr->_leftSon != NULL) || (curr->_rightSon != NULL))
+            curr = curr->_leftSon != NULL ? curr->_leftSon : curr->_rightSon;
+    }
+    return curr;
+}
+
+/* Returns the node that follows a given one in a visit of the given type of
+ * the tree rooted in root, or NULL if it's the last one. Breadth-first visits
+ * also need the depth of the node, which gets updated.
+ */
+AVLIntNode *_intTraverseNext(AVLIntNode *root, AVLIntNode *node, int type,
+                             int *depth) {
+    AVLIntNode *curr = node;
+    AVLIntNode *father;
+    if (type & DFS_IN_ORDER) {
+        // Go to the right subtree, or up to the first father on the right.
+        if (curr->_rightSon != NULL)
+            return _intTraverseFirst(curr->_rightSon, DFS_IN_ORDER);
+        father = curr->_father;
+        while ((father != NULL) && (father->_rightSon == curr)) {
+            curr = father;
+            father = curr->_father;
+        }
+        return father;
+    } else if (type & DFS_PRE_ORDER) {
+        // Go down if possible, else up to the first right subtree not visited.
+        if (curr->_leftSon != NULL) return curr->_leftSon;
+        if (curr->_rightSon != NULL) return curr->_rightSon;
+        father = curr->_father;
+        while ((father != NULL) && ((father->_rightSon == curr) ||
+                                    (father->_rightSon == NULL))) {
+            curr = father;
+            father = curr->_father;
+        }
+        return father != NULL ? father->_rightSon : NULL;
+    } else if (type & DFS_POST_ORDER) {
+        // Visit the right subtree of the father, if not done yet, then him.
+        father = curr->_father;
+        if ((father != NULL) && (father->_leftSon == curr) &&
+            (father->_rightSon != NULL))
+            return _intTraverseFirst(father->_rightSon, DFS_POST_ORDER);
+        return father;
+    }
+    // Breadth-first visit: move along the level, or on to the next one.
+    int leftFirst = (type & BFS_LEFT_FIRST) ? 1 : 0;
+    AVLIntNode *next = _intLevelNext(curr, leftFirst);
+    if (next == NULL) {
+        (*depth)++;
+        next = _intLevelFirst(root, *depth, leftFirst);
+    }
+    return next;
+}
+
+/* Returns the first node found at the given depth in a subtree, looking from
+ * left to right or from right to left, or NULL if there's none.
+ */
+AVLIntNode *_intLevelFirst(AVLIntNode *node, int depth, int leftFirst) {
+    if (node == NULL) return NULL;
+    if (depth == 0) return node;
+    if (node->_height < depth) return NULL;  // Not deep enough.
+    AVLIntNode *first = leftFirst ? node->_leftSon : node->_rightSon;
+    AVLIntNode *second = leftFirst ? node->_rightSon : node->_leftSon;
+    AVLIntNode *found = _intLevelFirst(first, depth - 1, leftFirst);
+    if (found != NULL) return found;
+    return _intLevelFirst(second, depth - 1, leftFirst);
+}
+
+/* Returns the node that follows a given one on its level, looking from left
+ * to right or from right to left, or NULL if it's the last one: climbs until
+ * a subtree not visited yet is found on the proper side, and looks there at
+ * the same depth.
+ */
+AVLIntNode *_intLevelNext(AVLIntNode *node, int leftFirst) {
+    AVLIntNode *curr = node;
+    AVLIntNode *father, *next;
+    int up = 0;
+    while (curr->_father != NULL) {
+        father = curr->_father;
+        up++;
+        next = leftFirst ? father->_rightSon : father->_leftSon;
+        if (next != curr) {
+            next = _intLevelFirst(next, up - 1, leftFirst);
+            if (next != NULL) return next;
+        }
+        curr = father;
+    }
+    return NULL;
+}
+
+/* Makes sure that a frontier of a level-by-level visit can hold the given
+ * number of nodes, doubling its capacity as needed, and charges the growth to
+ * the tree's budget, quietly since the tree is being visited.
+ * Returns 0 if successful, -1 if memory could not be allocated or the budget
+ * refused it.
+ */
+int _intGrowFrontier(AVLIntTree *tree, AVLIntNode ***frontier,
+                     unsigned long int *capacity, unsigned long int needed) {
+    if (*capacity >= needed) return 0;
+    unsigned long int newCap = *capacity > 0 ? *capacity : 1;
+    while (newCap < needed) newCap <<= 1;
+    unsigned long int bytes = (newCap - *capacity) * sizeof(AVLIntNode *);
+    if (_intCharge(tree, bytes, 1) != 0) return -1;
+    AVLIntNode **newFrontier = (AVLIntNode **) realloc(
+        *frontier, newCap * sizeof(AVLIntNode *));
+    if (newFrontier == NULL) {
+        _intRelease(tree, bytes);
+        return -1;
+    }
+    *frontier = newFrontier;
+    *capacity = newCap;
+    return 0;
+}
+
+/* Allocates the result array of a visit, of the size required by the given
+ * options, and tells which one of them is going to be used.
+ */
+void *_intAllocVisit(unsigned long int count, int opts, int *intOpt) {
+    if (opts & SEARCH_DATA) {
+        *intOpt = SEARCH_DATA;
+        return calloc(count, sizeof(void *));
+    } else if (opts & SEARCH_KEYS) {
+        *intOpt = SEARCH_KEYS;
+        return calloc(count, sizeof(int));
+    } else if (opts & SEARCH_NODES) {
+        *intOpt = SEARCH_NODES;
+        return calloc(count, sizeof(AVLIntNode *));
+    }
+    return NULL;  // Invalid option.
+}
+
+/* Stores what the option requires of a node at a given position of the result
+ * array of a visit.
+ */
+void _intStoreEntry(void *res, unsigned long int pos, AVLIntNode *node,
+                    int intOpt) {
+    if (intOpt & SEARCH_NODES) {
+        ((void **) res)[pos] = node;
+    } else if (intOpt & SEARCH_KEYS) {
+        ((int *) res)[pos] = node->_key;
+    } else if (intOpt & SEARCH_DATA) {
+        ((void **) res)[pos] = node->_data;
+    }
+}
+
+/* Returns the depth at which a tree of the given height has to be cut to get
+ * enough subtrees for the given number of threads.
+ */
+int _intCutDepth(int height, int nthreads) {
+    int cutDepth = 0;
+    while (((1UL << cutDepth) <
+            (unsigned long int) nthreads * PAR_TASKS_PER_THREAD) &&
+           (cutDepth < height)) cutDepth++;
+    return cutDepth;
+}
+
+/* Performs a recursive DFS of a subtree, storing the entries starting from
+ * the given offset of the result array.
+ */
+void _intDFSAt(AVLIntParVisit *visit, AVLIntNode *node,
+               unsigned long int offset) {
+    if (node == NULL) return;
+    unsigned long int leftSize = _intSize(node->_leftSon);
+    unsigned long int rightSize = _intSize(node->_rightSon);
+    if (visit->_type & DFS_PRE_ORDER) {
+        _intStoreEntry(visit->_res, offset, node, visit->_intOpt);
+        _intDFSAt(visit, node->_leftSon, offset + 1);
+        _intDFSAt(visit, node->_rightSon, offset + 1 + leftSize);
+    } else if (visit->_type & DFS_IN_ORDER) {
+        _intDFSAt(visit, node->_leftSon, offset);
+        _intStoreEntry(visit->_res, offset + leftSize, node, visit->_intOpt);
+        _intDFSAt(visit, node->_rightSon, offset + leftSize + 1);
+    } else {
+        _intDFSAt(visit, node->_leftSon, offset);
+        _intDFSAt(visit, node->_rightSon, offset + leftSize);
+        _intStoreEntry(visit->_res, offset + leftSize + rightSize, node,
+                       visit->_intOpt);
+    }
+}
+
+/* Performs a step of a parallel DFS: stores the root of the subtree, then
+ * visits its sons, the left one in a new task. Subtrees not bigger than the
+ * grain are visited sequentially.
+ */
+void _intParDFS(void *arg) {
+    AVLIntParStep *step = (AVLIntParStep *) arg;
+    AVLIntParVisit *visit = step->_visit;
+    AVLIntNode *node = step->_node;
+    if ((node == NULL) || (node->_size <= visit->_grain)) {
+        _intDFSAt(visit, node, step->_offset);
+        return;
+    }
+    unsigned long int leftSize = _intSize(node->_leftSon);
+    unsigned long int rightSize = _intSize(node->_rightSon);
+    AVLIntParStep left = {visit, node->_leftSon, step->_offset};
+    AVLIntParStep right = {visit, node->_rightSon, step->_offset + leftSize};
+    if (visit->_type & DFS_PRE_ORDER) {
+        _intStoreEntry(visit->_res, step->_offset, node, visit->_intOpt);
+        left._offset++;
+        right._offset++;
+    } else if (visit->_type & DFS_IN_ORDER) {
+        _intStoreEntry(visit->_res, step->_offset + leftSize, node,
+                       visit->_intOpt);
+        right._offset++;
+    } else {
+        _intStoreEntry(visit->_res, step->_offset + leftSize + rightSize, node,
+                       visit->_intOpt);
+    }
+    AVLWorkTask task;
+    workPoolSpawn(&task, _intParDFS, &left);
+    _intParDFS(&right);
+    workPoolSync(&task);
+}
+
+/* Performs a recursive DFS of a subtree meeting the nodes of each level in the
+ * order required by a BFS, and either counts them or stores them at the
+ * cursor of their level in the given row of the offsets matrix.
+ * Row zero is the top of the tree, so its visit stops at the cut depth.
+ */
+void _intLevelVisit(AVLIntParVisit *visit, AVLIntNode *node, int depth,
+                    unsigned long int row) {
+    if (node == NULL) return;
+    if ((row == 0) && (depth == visit->_cutDepth)) return;
+    unsigned long int *cell = visit->_offsets + row * visit->_levels + depth;
+    if (visit->_store)
+        _intStoreEntry(visit->_res, *cell, node, visit->_intOpt);
+    (*cell)++;
+    if (visit->_type & BFS_LEFT_FIRST) {
+        _intLevelVisit(visit, node->_leftSon, depth + 1, row);
+        _intLevelVisit(visit, node->_rightSon, depth + 1, row);
+    } else {
+        _intLevelVisit(visit, node->_rightSon, depth + 1, row);
+        _intLevelVisit(visit, node->_leftSon, depth + 1, row);
+    }
+}
+
+/* Collects the subtrees rooted at the cut depth, in the order in which a BFS
+ * would meet them.
+ */
+void _intParBFSSplit(AVLIntParVisit *visit, AVLIntNode *node, int depth) {
+    if (node == NULL) return;
+    if (depth == visit->_cutDepth) {
+        visit->_roots[visit->_nTasks] = node;
+        visit->_nTasks++;
+        return;
+    }
+    if (visit->_type & BFS_LEFT_FIRST) {
+        _intParBFSSplit(visit, node->_leftSon, depth + 1);
+        _intParBFSSplit(visit, node->_rightSon, depth + 1);
+    } else {
+        _intParBFSSplit(visit, node->_rightSon, depth + 1);
+        _intParBFSSplit(visit, node->_leftSon, depth + 1);
+    }
+}
+
+/* Visits one of the subtrees of a parallel BFS. */
+void _intParBFSTask(void *arg, unsigned long int task) {
+    AVLIntParVisit *visit = (AVLIntParVisit *) arg;
+    _intLevelVisit(visit, visit->_roots[task], visit->_cutDepth, task + 1);
+}
+
+/* Copies a chunk of the input of a parallel build in the entries to sort. */
+void _intParLoadTask(void *arg, unsigned long int chunk) {
+    AVLIntParBuild *build = (AVLIntParBuild *) arg;
+    unsigned long int lo = chunk * build->_n / build->_nChunks;
+    unsigned long int hi = (chunk + 1) * build->_n / build->_nChunks;
+    for (unsigned long int i = lo; i < hi; i++) {
+        build->_pairs[i]._key = build->_keys[i];
+        build->_pairs[i]._data = (build->_data != NULL) ? build->_data[i] :
+                                 NULL;
+    }
+}
+
+/* Counts the digits of the keys in a chunk of the entries to sort. */
+void _intParCountTask(void *arg, unsigned long int chunk) {
+    AVLIntParBuild *build = (AVLIntParBuild *) arg;
+    unsigned long int lo = chunk * build->_n / build->_nChunks;
+    unsigned long int hi = (chunk + 1) * build->_n / build->_nChunks;
+    unsigned long int *counts = build->_counts + chunk * RADIX_BUCKETS;
+    for (int digit = 0; digit < RADIX_BUCKETS; digit++) counts[digit] = 0;
+    for (unsigned long int i = lo; i < hi; i++)
+        counts[RADIX_DIGIT(build->_pairs[i]._key, build->_shift)]++;
+}
+
+/* Moves the entries in a chunk to their place according to their digits. */
+void _intParScatterTask(void *arg, unsigned long int chunk) {
+    AVLIntParBuild *build = (AVLIntParBuild *) arg;
+    unsigned long int lo = chunk * build->_n / build->_nChunks;
+    unsigned long int hi = (chunk + 1) * build->_n / build->_nChunks;
+    unsigned long int *cursors = build->_counts + chunk * RADIX_BUCKETS;
+    for (unsigned long int i = lo; i < hi; i++) {
+        build->_tmp[cursors[RADIX_DIGIT(build->_pairs[i]._key,
+                                        build->_shift)]++] = build->_pairs[i];
+    }
+}
+
+/* Returns the height of a perfectly balanced tree with the given number of
+ * nodes.
+ */
+int _intBuildHeight(unsigned long int count) {
+    int height = -1;
+    while (count > 0) {
+        count >>= 1;
+        height++;
+    }
+    return height;
+}
+
+/* Performs a step of a parallel build: builds a perfectly balanced subtree
+ * from a range of the sorted entries, taking the middle one as root, and
+ * attaches it in the given place. The left son is built by a new task, unless
+ * the subtree is not bigger than the grain.
+ */
+void _intParBuild(void *arg) {
+    AVLIntBuildStep *step = (AVLIntBuildStep *) arg;
+    AVLIntParBuild *build = step->_build;
+    *(step->_slot) = NULL;
+    if (step->_lo >= step->_hi) return;
+    unsigned long int mid = step->_lo + (step->_hi - step->_lo) / 2;
+    AVLIntNode *newNode = _createIntNode(build->_pairs[mid]._key,
+                                         build->_pairs[mid]._data, 0);
+    if (newNode == NULL) {
+        __atomic_store_n(&(build->_failed), 1, __ATOMIC_RELAXED);
+        return;
+    }
+    newNode->_father = step->_father;
+    newNode->_height = _intBuildHeight(step->_hi - step->_lo);
+    newNode->_size = step->_hi - step->_lo;
+    *(step->_slot) = newNode;
+    AVLIntBuildStep left = {build, newNode, &(newNode->_leftSon), step->_lo,
+                            mid};
+    AVLIntBuildStep right = {build, newNode, &(newNode->_rightSon), mid + 1,
+                             step->_hi};
+    if (newNode->_size > build->_grain) {
+        AVLWorkTask task;
+        workPoolSpawn(&task, _intParBuild, &left);
+        _intParBuild(&right);
+        workPoolSync(&task);
+    } else {
+        _intParBuild(&left);
+        _intParBuild(&right);
+    }
+}
+
+/* Frees all the nodes of a subtree, recursively. */
+void _intFreeSubtree(AVLIntNode *node) {
+    if (node == NULL) return;
+    _intFreeSubtree(node->_leftSon);
+    _intFreeSubtree(node->_rightSon);
+    _deleteIntNode(node);
+}
+
+/* Folds a subtree recursively following the order of the keys, either
+ * calling the function on each entry or reducing them, starting from the given
+ * accumulated value. Returns the new accumulated value.
+ */
+void *_intFold(AVLIntParFold *fold, AVLIntNode *node, void *acc) {
+    while (node != NULL) {
+        acc = _intFold(fold, node->_leftSon, acc);
+        if (fold->_forEach != NULL) {
+            fold->_forEach(node->_key, node->_data, fold->_ctx);
+        } else acc = fold->_reduce(acc, node->_key, node->_data, fold->_ctx);
+        node = node->_rightSon;
+    }
+    return acc;
+}
+
+/* Performs a step of a parallel fold: folds the sons of a subtree, the left
+ * one in a new task, then adds the root to the result of the left son and
+ * combines it with the result of the right one. Subtrees not bigger than the
+ * grain are folded sequentially.
+ */
+void _intParFold(void *arg) {
+    AVLIntFoldStep *step = (AVLIntFoldStep *) arg;
+    AVLIntParFold *fold = step->_fold;
+    AVLIntNode *node = step->_node;
+    if ((node == NULL) || (node->_size <= fold->_grain)) {
+        step->_acc = _intFold(fold, node, fold->_identity);
+        return;
+    }
+    AVLIntFoldStep left = {fold, node->_leftSon, fold->_identity};
+    AVLIntFoldStep right = {fold, node->_rightSon, fold->_identity};
+    AVLWorkTask task;
+    workPoolSpawn(&task, _intParFold, &left);
+    _intParFold(&right);
+    workPoolSync(&task);
+    if (fold->_forEach != NULL) {
+        fold->_forEach(node->_key, node->_data, fold->_ctx);
+    } else {
+        step->_acc = fold->_combine(fold->_reduce(left._acc, node->_key,
+                                                  node->_data, fold->_ctx),
+                                    right._acc, fold->_ctx);
+    }
+}
@@ -1,6 +1,6 @@
 /* Roberto Masocco
  * Creation Date: 26/7/2019
- * Latest Version: 26/7/2019
+ * Latest Version: 17/10/2026
  * ----------------------------------------------------------------------------
  * This file contains type definitions and declarations for the AVL Tree data
  * structure. See the source file for brief descriptions of what each function
@@ -17,6 +17,9 @@
 #ifndef AVLTREES_INTEGERKEYS_H
 #define AVLTREES_INTEGERKEYS_H
 
+#include "../AVLTrees_Common/AVLTree_WorkPool.h"
+#include "../AVLTrees_Common/AVLTree_MemBudget.h"
+
 /* These options can be OR'd in a call to the delete functions to specify
  * if also the keys and/or the data in the nodes must be freed in the heap.
  * If nothing is specified, only the nodes are freed.
@@ -44,8 +47,28 @@
 #define BFS_LEFT_FIRST 0x100
 #define BFS_RIGHT_FIRST 0x200
 
+/* The cache of the nodes found by searches (see intSetCache) can have at most
+ * 2^CACHE_MAX_BITS slots: bigger sizes are cut down to that.
+ */
+#define CACHE_MAX_BITS 30
+
+/* These options can be specified to tell a bounded tree which entry to evict
+ * when it's full and a new one comes in: the one with the smallest or greatest
+ * key, or the least recently used one. Only one at a time is allowed.
+ * WARNING: with EVICT_LRU, every search that finds an entry (intSearch and
+ * intFingerSearch) moves it in a list kept in the tree, so searches modify the
+ * tree and can't run concurrently with each other, or with anything else.
+ */
+#define EVICT_MIN_KEY 0x400
+#define EVICT_MAX_KEY 0x800
+#define EVICT_LRU 0x1000
+
 /* An AVL Tree's node stores pointers to its "father" node and to its sons.
  * To calculate the balance factor, the height of the node is also stored.
+ * The number of nodes in the subtree rooted in each node is kept too, so that
+ * the position of every entry in a visit can be computed without visiting the
+ * ones that come before it.
+ * Nodes can also be kept in a list, from the most to the least recently used.
  * In this implementation, integers are used as keys in the dictionary.
  * The data kept inside the node can be everything, as long as it's at most
  * 64-bits wide. These can be pointers, too.
@@ -57,31 +80,165 @@ typedef struct _avlIntNode {
     struct _avlIntNode *_father;
     struct _avlIntNode *_leftSon;
     struct _avlIntNode *_rightSon;
+    struct _avlIntNode *_newer;
+    struct _avlIntNode *_older;
+    unsigned long int _size;
     int _height;
     int _key;
     void *_data;
 } AVLIntNode;
 
+/* A slot of a tree's hash index, which maps keys to the nodes that hold them.
+ * The key is stored here too, to avoid reaching the node unless it matches.
+ */
+typedef struct {
+    AVLIntNode *_node;
+    int _key;
+} AVLIntIndexSlot;
+
+/* A tree can be augmented with a summary of each subtree (e.g. the sum, the
+ * minimum or the maximum of some values in it), stored in augSize bytes that
+ * follow each node, suitably aligned for any type. The summary of a subtree
+ * is computed from that of its root's entry alone, given by entry, and those
+ * of its sons, joined in order by combine, which must be associative (the
+ * result of combine may be stored in the same place as either of the
+ * summaries it's given). Both receive ctx as their last argument.
+ * Summaries are recomputed as nodes are inserted, deleted and rotated, so
+ * they are always up to date, as long as the data in the nodes is not changed
+ * from outside.
+ */
+typedef struct {
+    unsigned long int augSize;
+    void (*entry)(void *aug, int key, void *data, void *ctx);
+    void (*combine)(void *aug, const void *aug1, const void *aug2, void *ctx);
+    void *ctx;
+} AVLIntAugment;
+
 /* An AVL Tree stores a pointer to its root node and a counter which keeps
  * track of the number of nodes in the structure, to get an idea of its "size"
  * and be able to efficiently perform searches.
  * AVL trees implemented like this have a size limit set by the maximum
  * amount representable with an unsigned long integer, automatically set (as
  * long as you compile this code on the same machine you're going to use it on).
+ * Optionally, a small sorted buffer can absorb insertions, which are then
+ * moved into the tree in sorted batches: buffered entries are counted as
+ * nodes too. Read-only operations never flush the buffer, and visits fail
+ * while it holds entries: call intFlushBuffer before visiting.
+ * A cache of recently found nodes can also be kept, in which case the number
+ * of searches it answered, or not, is counted. For exact searches in constant
+ * time, a hash index of all the nodes can be kept instead (or too).
+ * The last node accessed by finger searches and insertions is remembered, so
+ * that the next ones can start from there.
+ * The nodes with the smallest and the greatest keys are always at hand, so
+ * that the tree can be used as a double-ended priority queue.
+ * Finally, a description of the summaries that augment its nodes is kept.
+ * When a tree is full, it can evict an entry to make room for a new one,
+ * following a policy, and deleting it with the options given.
+ * The number of bytes the tree is using, for itself, its entries and all its
+ * auxiliary structures, and those that operations are using while they run,
+ * is kept up to date, and can be charged to a memory budget (see
+ * AVLTrees_Common). Memory used by the data, and the arrays returned to the
+ * caller, are not counted.
  */
 typedef struct {
     AVLIntNode *_root;
     unsigned long int nodesCount;
     unsigned long int maxNodes;
+    int *_bufKeys;
+    void **_bufData;
+    unsigned long int _buffered;
+    unsigned long int _bufCapacity;
+    AVLIntNode **_cache;
+    int _cacheBits;
+    unsigned long int cacheHits;
+    unsigned long int cacheMisses;
+    AVLIntIndexSlot *_index;
+    int _indexBits;
+    unsigned long int _indexUsed;
+    AVLIntNode *_finger;
+    AVLIntNode *_minNode;
+    AVLIntNode *_maxNode;
+    AVLIntAugment _augment;
+    int _evictPolicy;
+    int _evictOpts;
+    AVLIntNode *_newest;
+    AVLIntNode *_oldest;
+    unsigned long int memUsed;
+    AVLMemBudget *_budget;
 } AVLIntTree;
 
+/* A cursor keeps track of where a visit into caller-provided arrays got to,
+ * so that it can be resumed by the next call: it holds the next node to be
+ * visited and, for breadth-first visits, its depth.
+ * Cursors must be reset before their first use, and become invalid as soon as
+ * the tree is modified.
+ */
+typedef struct {
+    AVLIntNode *_node;
+    int _depth;
+    int _type;
+    int _started;
+} AVLIntCursor;
+
 /* Library functions. */
 AVLIntTree *createIntTree(void);
 int deleteIntTree(AVLIntTree *tree, int opts);
 void *intSearch(AVLIntTree *tree, int key, int opts);
 unsigned long int intInsert(AVLIntTree *tree, int newKey, void *newData);
 int intDelete(AVLIntTree *tree, int key, int opts);
+int intDeleteNode(AVLIntTree *tree, AVLIntNode *node, int opts);
+void *intFingerSearch(AVLIntTree *tree, AVLIntNode *finger, int key, int opts);
+unsigned long int intContainsSorted(AVLIntTree *tree, int *keys,
+                                    unsigned long int n,
+                                    unsigned char *bitmap);
+unsigned long int intFingerInsert(AVLIntTree *tree, AVLIntNode *finger,
+                                  int newKey, void *newData);
 void **intDFS(AVLIntTree *tree, int type, int opts);
 void **intBFS(AVLIntTree *tree, int type, int opts);
+void **intLevelBFS(AVLIntTree *tree, int type, int opts, int maxDepth,
+                   unsigned long int **levels, int *nLevels);
+void intResetCursor(AVLIntCursor *cursor);
+unsigned long int intTraverseInto(AVLIntTree *tree, int type, int *keys,
+                                  void **data, unsigned long int capacity,
+                                  AVLIntCursor *cursor);
+unsigned long int intSampleRandom(AVLIntTree *tree, unsigned short rng[3],
+                                  unsigned long int k, int *keys,
+                                  void **data);
+unsigned long int intSampleSorted(AVLIntTree *tree, unsigned short rng[3],
+                                  unsigned long int k, int *keys,
+                                  void **data);
+unsigned long int intTopK(AVLIntTree *tree, unsigned long int k, int *keys,
+                          void **data);
+unsigned long int intBottomK(AVLIntTree *tree, unsigned long int k, int *keys,
+                             void **data);
+int intMin(AVLIntTree *tree, int *key, void **data);
+int intMax(AVLIntTree *tree, int *key, void **data);
+int intPopMin(AVLIntTree *tree, int *key, void **data);
+int intPopMax(AVLIntTree *tree, int *key, void **data);
+int intSetAugment(AVLIntTree *tree, const AVLIntAugment *augment);
+int intRangeAggregate(AVLIntTree *tree, int lo, int hi, void *result);
+int intSetCapacity(AVLIntTree *tree, unsigned long int maxNodes, int policy,
+                   int opts);
+unsigned long int intShed(AVLIntTree *tree, unsigned long int bytes);
+int intSetBudget(AVLIntTree *tree, AVLMemBudget *budget);
+int intSetBuffer(AVLIntTree *tree, unsigned long int capacity);
+int intFlushBuffer(AVLIntTree *tree);
+int intSetCache(AVLIntTree *tree, unsigned long int size);
+int intSetIndex(AVLIntTree *tree, int enable);
+unsigned long int intIndexMemory(AVLIntTree *tree);
+void **intParallelDFS(AVLIntTree *tree, int type, int opts,
+                      AVLWorkPool *pool);
+void **intParallelBFS(AVLIntTree *tree, int type, int opts,
+                      AVLWorkPool *pool);
+AVLIntTree *intBuildParallel(int *keys, void **data, unsigned long int n,
+                             AVLWorkPool *pool);
+int intParallelForEach(AVLIntTree *tree,
+                       void (*fn)(int key, void *data, void *ctx),
+                       void *ctx, AVLWorkPool *pool);
+void *intParallelReduce(AVLIntTree *tree,
+                        void *(*reduce)(void *acc, int key, void *data,
+                                        void *ctx),
+                        void *(*combine)(void *acc1, void *acc2, void *ctx),
+                        void *identity, void *ctx, AVLWorkPool *pool);
 
 #endif
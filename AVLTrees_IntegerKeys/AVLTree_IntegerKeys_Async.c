@@ -0,0 +1,498 @@
+/* AVL Trees library contributors
+ * Creation Date: 17/10/2026
+ * Latest Version: 17/10/2026
+ * ----------------------------------------------------------------------------
+ * This is the source file for the asynchronous write path of the AVL Trees
+ * with integer keys.
+ * Many producer threads queue insertions and deletions in a lock-free ring
+ * buffer (the bounded multi-producer queue by D. Vyukov, with a single
+ * consumer), and a dedicated applier thread drains them in batches, sorting
+ * each batch by key so that consecutive updates touch nearby nodes. Readers
+ * never touch the tree: they get a reference to the latest published snapshot
+ * and search it as a sorted array.
+ * See the comments above each function definition for information about what
+ * each one does.
+ */
+/* This code is released under the MIT license.
+ * See the attached LICENSE file.
+ */
+
+#include <stdlib.h>
+#include <limits.h>
+#include <time.h>
+#include <sched.h>
+#include <pthread.h>
+#include "AVLTree_IntegerKeys_Async.h"
+
+/* Macro to compare two integers without risking the overflows that a
+ * subtraction would cause: evaluates to 1, 0 or -1.
+ */
+#define COMPARE(X, Y) (((X) > (Y)) - ((X) < (Y)))
+
+/* Number of times the applier looks for operations before going to sleep. */
+#define ASYNC_SPINS 64
+
+/* Minimum time between snapshots published when the applier runs out of work,
+ * if there's no publishing period, in nanoseconds: copying the whole tree at
+ * every small batch would leave it behind the producers.
+ */
+#define ASYNC_PUBLISH_GAP 10000000L
+
+/* Internal library subroutines declarations. */
+int _intAsyncEnqueue(AVLIntAsyncTree *async, int op, int key, void *data);
+unsigned long int _intAsyncDrain(AVLIntAsyncTree *async);
+int _intAsyncReady(AVLIntAsyncTree *async);
+int _intCompareOps(const void *op1, const void *op2);
+void _intAsyncApply(AVLIntAsyncTree *async, unsigned long int count);
+void _intSnapshotFill(AVLIntSnapshot *snap, AVLIntNode *node,
+                      unsigned long int *pos);
+AVLIntSnapshot *_intCreateSnapshot(AVLIntTree *tree);
+void _intAsyncPublish(AVLIntAsyncTree *async);
+long int _intAsyncElapsed(const struct timespec *since);
+void _intAsyncNap(AVLIntAsyncTree *async, int unpublished, long int timeout);
+void *_intAsyncApplier(void *arg);
+
+// USER FUNCTIONS //
+/* Wraps a tree in a new asynchronous tree, starting its applier thread.
+ * The ring buffer holds at least the given number of operations (rounded up
+ * to a power of two), the applier applies at most batchSize of them at a time
+ * (zero means as many as the ring can hold), and publishes a new snapshot
+ * after every publishEvery of them, or when a thread flushes (zero means also
+ * when it runs out of work, at most once every ASYNC_PUBLISH_GAP). Since each
+ * snapshot copies the whole tree, publishEvery should not be much smaller
+ * than the number of entries. Deletions are performed with the given options.
+ * From now on, the tree must only be accessed through the asynchronous one.
+ * Returns NULL if something could not be allocated or started.
+ */
+AVLIntAsyncTree *createIntAsyncTree(AVLIntTree *tree,
+                                    unsigned long int capacity,
+                                    unsigned long int batchSize,
+                                    unsigned long int publishEvery, int opts) {
+    // Sanity check on input arguments.
+    if ((tree == NULL) || (capacity == 0) || (opts < 0)) return NULL;
+    unsigned long int size = 2;
+    while (size < capacity) {
+        if (size > (ULONG_MAX >> 2)) return NULL;
+        size <<= 1;
+    }
+    AVLIntAsyncTree *newAsync = (AVLIntAsyncTree *) malloc(
+            sizeof(AVLIntAsyncTree));
+    if (newAsync == NULL) return NULL;
+    if ((batchSize == 0) || (batchSize > size)) batchSize = size;
+    newAsync->tree = tree;
+    newAsync->_ring = (AVLIntAsyncOp *) calloc(size, sizeof(AVLIntAsyncOp));
+    newAsync->_batch = (AVLIntAsyncOp *) calloc(batchSize,
+                                                sizeof(AVLIntAsyncOp));
+    newAsync->_snapshot = _intCreateSnapshot(tree);
+    if ((newAsync->_ring == NULL) || (newAsync->_batch == NULL) ||
+        (newAsync->_snapshot == NULL)) {
+        free(newAsync->_ring);
+        free(newAsync->_batch);
+        intReleaseSnapshot(newAsync->_snapshot);
+        free(newAsync);
+        return NULL;
+    }
+    // Each slot starts waiting for the producer that will reserve it first.
+    for (unsigned long int i = 0; i < size; i++) newAsync->_ring[i]._seq = i;
+    newAsync->_mask = size - 1;
+    newAsync->_head = 0;
+    newAsync->_tail = 0;
+    newAsync->batchSize = batchSize;
+    newAsync->publishEvery = publishEvery;
+    newAsync->failedOps = 0;
+    newAsync->_failedSeen = 0;
+    newAsync->_deleteOpts = opts;
+    newAsync->_published = 0;
+    newAsync->_sleeping = 0;
+    newAsync->_flushing = 0;
+    newAsync->_stop = 0;
+    pthread_mutex_init(&(newAsync->_lock), NULL);
+    pthread_mutex_init(&(newAsync->_snapLock), NULL);
+    pthread_cond_init(&(newAsync->_wakeUp), NULL);
+    pthread_cond_init(&(newAsync->_publish), NULL);
+    if (pthread_create(&(newAsync->_applier), NULL, _intAsyncApplier,
+                       newAsync) != 0) {
+        pthread_mutex_destroy(&(newAsync->_lock));
+        pthread_mutex_destroy(&(newAsync->_snapLock));
+        pthread_cond_destroy(&(newAsync->_wakeUp));
+        pthread_cond_destroy(&(newAsync->_publish));
+        free(newAsync->_ring);
+        free(newAsync->_batch);
+        intReleaseSnapshot(newAsync->_snapshot);
+        free(newAsync);
+        return NULL;
+    }
+    return newAsync;
+}
+
+/* Applies all the queued operations, stops the applier and frees the
+ * asynchronous tree from the heap. Snapshots still held by readers stay valid
+ * until they are released.
+ * No producers must be running when this is called.
+ * Returns the wrapped tree, which can then be used as usual.
+ */
+AVLIntTree *deleteIntAsyncTree(AVLIntAsyncTree *async) {
+    if (async == NULL) return NULL;  // Sanity check.
+    pthread_mutex_lock(&(async->_lock));
+    __atomic_store_n(&(async->_stop), 1, __ATOMIC_RELAXED);
+    pthread_cond_signal(&(async->_wakeUp));
+    pthread_mutex_unlock(&(async->_lock));
+    pthread_join(async->_applier, NULL);
+    AVLIntTree *tree = async->tree;
+    intReleaseSnapshot(async->_snapshot);
+    pthread_mutex_destroy(&(async->_lock));
+    pthread_mutex_destroy(&(async->_snapLock));
+    pthread_cond_destroy(&(async->_wakeUp));
+    pthread_cond_destroy(&(async->_publish));
+    free(async->_ring);
+    free(async->_batch);
+    free(async);
+    return tree;
+}
+
+/* Queues the insertion of a new entry in the tree.
+ * Returns 0 if successful, -1 if the ring buffer is full (in which case the
+ * caller may retry later, or flush).
+ */
+int intAsyncInsert(AVLIntAsyncTree *async, int newKey, void *newData) {
+    if (async == NULL) return -1;  // Sanity check.
+    return _intAsyncEnqueue(async, ASYNC_INSERT, newKey, newData);
+}
+
+/* Queues the deletion of an entry from the tree.
+ * Returns 0 if successful, -1 if the ring buffer is full (in which case the
+ * caller may retry later, or flush).
+ */
+int intAsyncDelete(AVLIntAsyncTree *async, int key) {
+    if (async == NULL) return -1;  // Sanity check.
+    return _intAsyncEnqueue(async, ASYNC_DELETE, key, NULL);
+}
+
+/* Waits until all the operations queued before this call have been applied,
+ * and a snapshot including them has been published (unless memory for it
+ * could not be allocated, in which case the previous one is kept). The
+ * applier publishes one as soon as it runs out of work while a thread waits
+ * here.
+ * Returns 0 if successful, -1 if some operations could not be applied since
+ * the last flush returned (see failedOps), or if the tree is NULL.
+ */
+int intAsyncFlush(AVLIntAsyncTree *async) {
+    if (async == NULL) return -1;  // Sanity check.
+    unsigned long int target = __atomic_load_n(&(async->_head),
+                                               __ATOMIC_ACQUIRE);
+    pthread_mutex_lock(&(async->_lock));
+    if ((long int) (async->_published - target) < 0) {
+        __atomic_add_fetch(&(async->_flushing), 1, __ATOMIC_RELAXED);
+        pthread_cond_signal(&(async->_wakeUp));
+        while ((long int) (async->_published - target) < 0)
+            pthread_cond_wait(&(async->_publish), &(async->_lock));
+        __atomic_sub_fetch(&(async->_flushing), 1, __ATOMIC_RELAXED);
+    }
+    // Tell about the failures only once, to the first flush that sees them.
+    unsigned long int failed = __atomic_load_n(&(async->failedOps),
+                                               __ATOMIC_RELAXED);
+    int res = (failed != async->_failedSeen) ? -1 : 0;
+    async->_failedSeen = failed;
+    pthread_mutex_unlock(&(async->_lock));
+    return res;
+}
+
+/* Returns the number of operations queued but not applied yet. Since
+ * producers and the applier keep running, this is only an estimate.
+ */
+unsigned long int intAsyncPending(AVLIntAsyncTree *async) {
+    if (async == NULL) return 0;  // Sanity check.
+    unsigned long int tail = __atomic_load_n(&(async->_tail),
+                                             __ATOMIC_RELAXED);
+    unsigned long int head = __atomic_load_n(&(async->_head),
+                                             __ATOMIC_RELAXED);
+    return ((long int) (head - tail) > 0) ? head - tail : 0;
+}
+
+/* Returns a reference to the latest published snapshot, which must be
+ * released with intReleaseSnapshot when done.
+ */
+AVLIntSnapshot *intAcquireSnapshot(AVLIntAsyncTree *async) {
+    if (async == NULL) return NULL;  // Sanity check.
+    pthread_mutex_lock(&(async->_snapLock));
+    AVLIntSnapshot *snap = async->_snapshot;
+    __atomic_add_fetch(&(snap->_refs), 1, __ATOMIC_RELAXED);
+    pthread_mutex_unlock(&(async->_snapLock));
+    return snap;
+}
+
+/* Releases a reference to a snapshot, freeing it if it was the last one. */
+void intReleaseSnapshot(AVLIntSnapshot *snap) {
+    if (snap == NULL) return;  // Sanity check.
+    if (__atomic_sub_fetch(&(snap->_refs), 1, __ATOMIC_ACQ_REL) == 0) {
+        free(snap->keys);
+        free(snap->data);
+        free(snap);
+    }
+}
+
+/* Searches for an entry with the specified key in a snapshot.
+ * With SEARCH_DATA the entry's data is returned, while with SEARCH_KEYS a
+ * pointer to its key inside the snapshot is, which is valid as long as the
+ * snapshot is held.
+ * Returns NULL if there's no such entry.
+ */
+void *intSnapshotSearch(AVLIntSnapshot *snap, int key, int opts) {
+    if ((opts <= 0) || (snap == NULL)) return NULL;  // Sanity check.
+    // Binary search for the first entry with a key not less than the given.
+    unsigned long int lo = 0, hi = snap->count, mid;
+    while (lo < hi) {
+        mid = lo + (hi - lo) / 2;
+        if (snap->keys[mid] < key) {
+            lo = mid + 1;
+        } else hi = mid;
+    }
+    if ((lo == snap->count) || (snap->keys[lo] != key)) return NULL;
+    if (opts & SEARCH_DATA) return snap->data[lo];
+    if (opts & SEARCH_KEYS) return snap->keys + lo;
+    return NULL;
+}
+
+// INTERNAL LIBRARY SUBROUTINES //
+/* Reserves a slot of the ring buffer and stores an operation in it, waking
+ * the applier up if it's sleeping.
+ * Returns 0 if successful, -1 if the ring buffer is full.
+ */
+int _intAsyncEnqueue(AVLIntAsyncTree *async, int op, int key, void *data) {
+    AVLIntAsyncOp *slot;
+    unsigned long int seq;
+    unsigned long int pos = __atomic_load_n(&(async->_head), __ATOMIC_RELAXED);
+    for (;;) {
+        slot = async->_ring + (pos & async->_mask);
+        seq = __atomic_load_n(&(slot->_seq), __ATOMIC_ACQUIRE);
+        if (seq == pos) {
+            // The slot is free: try to reserve it.
+            if (__atomic_compare_exchange_n(&(async->_head), &pos, pos + 1, 1,
+                                            __ATOMIC_RELAXED,
+                                            __ATOMIC_RELAXED)) break;
+        } else if ((long int) (seq - pos) < 0) {
+            return -1;  // The slot still holds an operation of the last lap.
+        } else pos = __atomic_load_n(&(async->_head), __ATOMIC_RELAXED);
+    }
+    slot->_op = op;
+    slot->_key = key;
+    slot->_data = data;
+    __atomic_store_n(&(slot->_seq), pos + 1, __ATOMIC_RELEASE);
+    // Wake the applier up, but only if needed.
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    if (__atomic_load_n(&(async->_sleeping), __ATOMIC_RELAXED)) {
+        pthread_mutex_lock(&(async->_lock));
+        pthread_cond_signal(&(async->_wakeUp));
+        pthread_mutex_unlock(&(async->_lock));
+    }
+    return 0;
+}
+
+/* Moves the ready operations from the ring buffer to the batch, at most
+ * batchSize of them, giving their slots back to the producers. Operations are
+ * numbered in the order in which they were queued.
+ * Returns the number of operations moved.
+ */
+unsigned long int _intAsyncDrain(AVLIntAsyncTree *async) {
+    AVLIntAsyncOp *slot;
+    unsigned long int count = 0, tail = async->_tail;
+    while (count < async->batchSize) {
+        slot = async->_ring + (tail & async->_mask);
+        if (__atomic_load_n(&(slot->_seq), __ATOMIC_ACQUIRE) != tail + 1)
+            break;  // Not written yet.
+        async->_batch[count] = *slot;
+        async->_batch[count]._seq = tail;
+        count++;
+        __atomic_store_n(&(slot->_seq), tail + async->_mask + 1,
+                         __ATOMIC_RELEASE);
+        tail++;
+    }
+    __atomic_store_n(&(async->_tail), tail, __ATOMIC_RELAXED);
+    return count;
+}
+
+/* Tells whether the next operation in the ring buffer is ready. */
+int _intAsyncReady(AVLIntAsyncTree *async) {
+    AVLIntAsyncOp *slot = async->_ring + (async->_tail & async->_mask);
+    return __atomic_load_n(&(slot->_seq), __ATOMIC_ACQUIRE) ==
+           async->_tail + 1;
+}
+
+/* Compares two queued operations by key, then by the order in which they
+ * were queued, for qsort.
+ */
+int _intCompareOps(const void *op1, const void *op2) {
+    const AVLIntAsyncOp *first = (const AVLIntAsyncOp *) op1;
+    const AVLIntAsyncOp *second = (const AVLIntAsyncOp *) op2;
+    int comp = COMPARE(first->_key, second->_key);
+    if (comp != 0) return comp;
+    return ((long int) (first->_seq - second->_seq) > 0) -
+           ((long int) (first->_seq - second->_seq) < 0);
+}
+
+/* Sorts the operations in the batch and applies them to the tree, counting
+ * the insertions that fail. Operations on the same key keep the order in
+ * which they were queued.
+ */
+void _intAsyncApply(AVLIntAsyncTree *async, unsigned long int count) {
+    qsort(async->_batch, count, sizeof(AVLIntAsyncOp), _intCompareOps);
+    for (unsigned long int i = 0; i < count; i++) {
+        if (async->_batch[i]._op == ASYNC_INSERT) {
+            if (intInsert(async->tree, async->_batch[i]._key,
+                          async->_batch[i]._data) == 0)
+                __atomic_add_fetch(&(async->failedOps), 1, __ATOMIC_RELAXED);
+        } else intDelete(async->tree, async->_batch[i]._key,
+                         async->_deleteOpts);
+    }
+}
+
+/* Copies the entries of a subtree in a snapshot, in order, starting from the
+ * given position.
+ */
+void _intSnapshotFill(AVLIntSnapshot *snap, AVLIntNode *node,
+                      unsigned long int *pos) {
+    while (node != NULL) {
+        _intSnapshotFill(snap, node->_leftSon, pos);
+        snap->keys[*pos] = node->_key;
+        snap->data[*pos] = node->_data;
+        (*pos)++;
+        node = node->_rightSon;
+    }
+}
+
+/* Creates a snapshot of the current contents of a tree, with a single
+ * reference to it.
+ * Returns NULL if memory could not be allocated.
+ */
+AVLIntSnapshot *_intCreateSnapshot(AVLIntTree *tree) {
+    if (intFlushBuffer(tree) != 0) return NULL;
+    AVLIntSnapshot *newSnap = (AVLIntSnapshot *) malloc(
+            sizeof(AVLIntSnapshot));
+    if (newSnap == NULL) return NULL;
+    newSnap->count = tree->nodesCount;
+    newSnap->_refs = 1;
+    newSnap->keys = NULL;
+    newSnap->data = NULL;
+    if (newSnap->count > 0) {
+        newSnap->keys = (int *) calloc(newSnap->count, sizeof(int));
+        newSnap->data = (void **) calloc(newSnap->count, sizeof(void *));
+        if ((newSnap->keys == NULL) || (newSnap->data == NULL)) {
+            free(newSnap->keys);
+            free(newSnap->data);
+            free(newSnap);
+            return NULL;
+        }
+    }
+    unsigned long int pos = 0;
+    _intSnapshotFill(newSnap, tree->_root, &pos);
+    return newSnap;
+}
+
+/* Publishes a snapshot of the tree as it is now, and tells the threads that
+ * are flushing how far it goes. If memory for it could not be allocated, the
+ * previous snapshot is kept.
+ */
+void _intAsyncPublish(AVLIntAsyncTree *async) {
+    AVLIntSnapshot *newSnap = _intCreateSnapshot(async->tree);
+    if (newSnap != NULL) {
+        pthread_mutex_lock(&(async->_snapLock));
+        AVLIntSnapshot *oldSnap = async->_snapshot;
+        async->_snapshot = newSnap;
+        pthread_mutex_unlock(&(async->_snapLock));
+        intReleaseSnapshot(oldSnap);
+    }
+    pthread_mutex_lock(&(async->_lock));
+    async->_published = async->_tail;
+    pthread_cond_broadcast(&(async->_publish));
+    pthread_mutex_unlock(&(async->_lock));
+}
+
+/* Returns the nanoseconds elapsed since the given time. */
+long int _intAsyncElapsed(const struct timespec *since) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (now.tv_sec - since->tv_sec) * 1000000000L +
+           (now.tv_nsec - since->tv_nsec);
+}
+
+/* Lets the applier sleep until a producer queues an operation, a thread
+ * flushes while there are unpublished operations, or it's being stopped,
+ * unless any of those already happened. If timeout is not negative, it sleeps
+ * for at most that many nanoseconds.
+ */
+void _intAsyncNap(AVLIntAsyncTree *async, int unpublished, long int timeout) {
+    struct timespec wakeTime;
+    if (timeout >= 0) {
+        clock_gettime(CLOCK_REALTIME, &wakeTime);
+        wakeTime.tv_sec += timeout / 1000000000L;
+        wakeTime.tv_nsec += timeout % 1000000000L;
+        if (wakeTime.tv_nsec >= 1000000000L) {
+            wakeTime.tv_sec++;
+            wakeTime.tv_nsec -= 1000000000L;
+        }
+    }
+    pthread_mutex_lock(&(async->_lock));
+    __atomic_store_n(&(async->_sleeping), 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    if (!_intAsyncReady(async) &&
+        !__atomic_load_n(&(async->_stop), __ATOMIC_RELAXED) &&
+        !(unpublished && __atomic_load_n(&(async->_flushing),
+                                         __ATOMIC_RELAXED))) {
+        if (timeout >= 0) {
+            pthread_cond_timedwait(&(async->_wakeUp), &(async->_lock),
+                                   &wakeTime);
+        } else pthread_cond_wait(&(async->_wakeUp), &(async->_lock));
+    }
+    __atomic_store_n(&(async->_sleeping), 0, __ATOMIC_RELAXED);
+    pthread_mutex_unlock(&(async->_lock));
+}
+
+/* Body of the applier thread: applies batches of operations, publishing
+ * snapshots as configured, until it's stopped and there's nothing left.
+ */
+void *_intAsyncApplier(void *arg) {
+    AVLIntAsyncTree *async = (AVLIntAsyncTree *) arg;
+    unsigned long int count, unpublished = 0;
+    long int gap = -1;
+    int idle = 0;
+    struct timespec lastPublish;
+    clock_gettime(CLOCK_MONOTONIC, &lastPublish);
+    for (;;) {
+        count = _intAsyncDrain(async);
+        if (count > 0) {
+            _intAsyncApply(async, count);
+            unpublished += count;
+            if ((async->publishEvery > 0) &&
+                (unpublished >= async->publishEvery)) {
+                _intAsyncPublish(async);
+                clock_gettime(CLOCK_MONOTONIC, &lastPublish);
+                unpublished = 0;
+            }
+            idle = 0;
+            continue;
+        }
+        // Out of work: let flushing threads see everything, and readers too
+        // if there's no publishing period and the last snapshot is not new.
+        if (unpublished > 0) {
+            if (async->publishEvery == 0)
+                gap = ASYNC_PUBLISH_GAP - _intAsyncElapsed(&lastPublish);
+            if (__atomic_load_n(&(async->_flushing), __ATOMIC_RELAXED) ||
+                ((async->publishEvery == 0) && (gap <= 0))) {
+                _intAsyncPublish(async);
+                clock_gettime(CLOCK_MONOTONIC, &lastPublish);
+                unpublished = 0;
+            }
+        }
+        if (__atomic_load_n(&(async->_stop), __ATOMIC_RELAXED)) break;
+        if (++idle < ASYNC_SPINS) {
+            sched_yield();
+            continue;
+        }
+        // Wake up in time to publish what's left, if nobody flushes it.
+        _intAsyncNap(async, unpublished > 0,
+                     ((unpublished > 0) && (async->publishEvery == 0)) ?
+                     gap : -1);
+        idle = 0;
+    }
+    return NULL;
+}
@@ -0,0 +1,102 @@
+/* AVL Trees library contributors
+ * Creation Date: 17/10/2026
+ * Latest Version: 17/10/2026
+ * ----------------------------------------------------------------------------
+ * This file contains type definitions and declarations for the asynchronous
+ * write path of the AVL Trees with integer keys. See the source file for brief
+ * descriptions of what each function does. Note that functions which names
+ * start with "_" are meant for internal use only, and only those without it
+ * should be used by the actual programmer.
+ */
+/* This code is released under the MIT license.
+ * See the attached LICENSE file.
+ */
+
+#ifndef AVLTREES_INTEGERKEYS_ASYNC_H
+#define AVLTREES_INTEGERKEYS_ASYNC_H
+
+#include <pthread.h>
+#include "AVLTree_IntegerKeys.h"
+
+/* These are the kinds of operations that can be queued on an asynchronous
+ * tree.
+ */
+#define ASYNC_INSERT 0x1
+#define ASYNC_DELETE 0x2
+
+/* A queued operation sits in a slot of the ring buffer, together with a
+ * sequence number that tells producers and the applier whose turn it is to
+ * use the slot.
+ */
+typedef struct {
+    unsigned long int _seq;
+    int _op;
+    int _key;
+    void *_data;
+} AVLIntAsyncOp;
+
+/* A snapshot is an immutable copy of the tree's contents, sorted by key, as
+ * they were at some point. It stays valid until its last reader releases it,
+ * no matter how many updates are applied in the meantime.
+ */
+typedef struct {
+    int *keys;
+    void **data;
+    unsigned long int count;
+    unsigned long int _refs;
+} AVLIntSnapshot;
+
+/* An asynchronous tree wraps an ordinary one, which only its applier thread
+ * modifies. Producers queue operations in a bounded ring buffer, which the
+ * applier drains in batches of at most batchSize operations, publishing a new
+ * snapshot every publishEvery applied operations, and whenever threads are
+ * flushing. If publishEvery is zero, it publishes one when it runs out of
+ * work instead, but not more often than every few milliseconds.
+ * Each snapshot is a full copy of the tree, so publishing takes time and
+ * memory proportional to the number of entries: with a publishEvery much
+ * smaller than that, the applier spends most of its time copying, and falls
+ * behind the producers.
+ * Insertions that the tree refuses (because it's full, its budget is
+ * exhausted, or memory could not be allocated) are counted in failedOps,
+ * since there's nobody to tell when they are applied. Deletions of keys that
+ * are not in the tree are not failures.
+ */
+typedef struct {
+    AVLIntTree *tree;
+    AVLIntAsyncOp *_ring;
+    unsigned long int _mask;
+    unsigned long int _head;
+    unsigned long int _tail;
+    AVLIntAsyncOp *_batch;
+    unsigned long int batchSize;
+    unsigned long int publishEvery;
+    unsigned long int failedOps;
+    unsigned long int _failedSeen;
+    int _deleteOpts;
+    AVLIntSnapshot *_snapshot;
+    unsigned long int _published;
+    pthread_t _applier;
+    pthread_mutex_t _lock;
+    pthread_mutex_t _snapLock;
+    pthread_cond_t _wakeUp;
+    pthread_cond_t _publish;
+    int _sleeping;
+    int _flushing;
+    int _stop;
+} AVLIntAsyncTree;
+
+/* Library functions. */
+AVLIntAsyncTree *createIntAsyncTree(AVLIntTree *tree,
+                                    unsigned long int capacity,
+                                    unsigned long int batchSize,
+                                    unsigned long int publishEvery, int opts);
+AVLIntTree *deleteIntAsyncTree(AVLIntAsyncTree *async);
+int intAsyncInsert(AVLIntAsyncTree *async, int newKey, void *newData);
+int intAsyncDelete(AVLIntAsyncTree *async, int key);
+int intAsyncFlush(AVLIntAsyncTree *async);
+unsigned long int intAsyncPending(AVLIntAsyncTree *async);
+AVLIntSnapshot *intAcquireSnapshot(AVLIntAsyncTree *async);
+void intReleaseSnapshot(AVLIntSnapshot *snap);
+void *intSnapshotSearch(AVLIntSnapshot *snap, int key, int opts);
+
+#endif
@@ -0,0 +1,208 @@
+/* AVL Trees library contributors
+ * Creation Date: 17/10/2026
+ * Latest Version: 17/10/2026
+ * ----------------------------------------------------------------------------
+ * This is the source file for the interval trees built on the AVL Trees with
+ * integer keys.
+ * Intervals are stored in an AVL tree using their lower ends as keys, and the
+ * tree is augmented so that each node knows the greatest upper end in its
+ * subtree, which is kept up to date through rotations like heights are.
+ * Queries can then skip every subtree whose intervals all end before the
+ * queried range, and every right subtree whose intervals all start after it.
+ * See the comments above each function definition for information about what
+ * each one does.
+ */
+/* This code is released under the MIT license.
+ * See the attached LICENSE file.
+ */
+
+#include <stdlib.h>
+#include "AVLTree_IntegerKeys_Intervals.h"
+
+/* Macro to get the address of the summary that augments a node, which
+ * follows it in memory.
+ */
+#define AUGMENT(NODE) ((void *) ((NODE) + 1))
+
+/* Macro to get the greatest upper end in the subtree of a node. */
+#define MAX_HI(NODE) (*((int *) AUGMENT(NODE)))
+
+/* Internal library subroutines declarations. */
+void _intIntervalEntry(void *aug, int key, void *data, void *ctx);
+void _intIntervalCombine(void *aug, const void *aug1, const void *aug2,
+                         void *ctx);
+AVLIntNode *_intIntervalFind(AVLIntNode *node, int lo, int hi);
+unsigned long int _intIntervalVisit(AVLIntNode *node, int lo, int hi,
+                                    void (*fn)(AVLIntInterval *interval,
+                                               void *ctx),
+                                    void *ctx);
+
+// USER FUNCTIONS //
+/* Creates a new, empty interval tree in the heap. */
+AVLIntIntervalTree *createIntIntervalTree(void) {
+    AVLIntAugment augment = {sizeof(int), _intIntervalEntry,
+                             _intIntervalCombine, NULL};
+    AVLIntIntervalTree *newTree = (AVLIntIntervalTree *) malloc(
+            sizeof(AVLIntIntervalTree));
+    if (newTree == NULL) return NULL;
+    newTree->_tree = createIntTree();
+    if ((newTree->_tree == NULL) ||
+        (intSetAugment(newTree->_tree, &augment) != 0)) {
+        deleteIntTree(newTree->_tree, 0);
+        free(newTree);
+        return NULL;
+    }
+    newTree->intervalsCount = 0;
+    return newTree;
+}
+
+/* Frees a given interval tree from the heap. Using options defined in the
+ * header of the AVL trees, it's possible to specify whether also the data of
+ * the intervals has to be freed or not.
+ */
+int deleteIntIntervalTree(AVLIntIntervalTree *itree, int opts) {
+    // Sanity check on input arguments.
+    if ((itree == NULL) || (opts < 0)) return -1;
+    if (opts & DELETE_FREE_DATA) {
+        // Collect the intervals a few at a time, to free their data.
+        void *intervals[64];
+        unsigned long int count;
+        AVLIntCursor cursor;
+        intResetCursor(&cursor);
+        while ((count = intTraverseInto(itree->_tree, DFS_IN_ORDER, NULL,
+                                        intervals, 64, &cursor)) > 0) {
+            for (unsigned long int i = 0; i < count; i++)
+                free(((AVLIntInterval *) intervals[i])->data);
+        }
+    }
+    // The intervals themselves are the data of the inner tree.
+    deleteIntTree(itree->_tree, DELETE_FREE_DATA);
+    free(itree);
+    return 0;
+}
+
+/* Creates and inserts a new interval in the tree, provided that lo is not
+ * greater than hi.
+ * Returns the new number of intervals, or 0 if the insertion failed.
+ */
+unsigned long int intIntervalInsert(AVLIntIntervalTree *itree, int lo, int hi,
+                                    void *data) {
+    // Sanity check on input arguments.
+    if ((itree == NULL) || (lo > hi)) return 0;
+    AVLIntInterval *newInterval = (AVLIntInterval *) malloc(
+            sizeof(AVLIntInterval));
+    if (newInterval == NULL) return 0;
+    newInterval->lo = lo;
+    newInterval->hi = hi;
+    newInterval->data = data;
+    if (intInsert(itree->_tree, lo, newInterval) == 0) {
+        free(newInterval);
+        return 0;
+    }
+    itree->intervalsCount++;
+    return itree->intervalsCount;
+}
+
+/* Deletes an interval with the given ends from the tree.
+ * Returns 1 if it was found and deleted, 0 otherwise.
+ */
+int intIntervalDelete(AVLIntIntervalTree *itree, int lo, int hi, int opts) {
+    // Sanity check on input arguments.
+    if ((itree == NULL) || (opts < 0)) return 0;
+    AVLIntNode *toDelete = _intIntervalFind(itree->_tree->_root, lo, hi);
+    if (toDelete == NULL) return 0;  // Not found.
+    AVLIntInterval *interval = (AVLIntInterval *) toDelete->_data;
+    intDeleteNode(itree->_tree, toDelete, 0);
+    if (opts & DELETE_FREE_DATA) free(interval->data);
+    free(interval);
+    itree->intervalsCount--;
+    return 1;
+}
+
+/* Calls a function on each interval that overlaps the one from lo to hi (both
+ * included), in order of their lower ends, passing it the given context too.
+ * The intervals must not be modified, nor the tree, until this returns.
+ * Returns the number of intervals found.
+ */
+unsigned long int intIntervalOverlap(AVLIntIntervalTree *itree, int lo, int hi,
+                                     void (*fn)(AVLIntInterval *interval,
+                                                void *ctx),
+                                     void *ctx) {
+    // Sanity check on input arguments.
+    if ((itree == NULL) || (fn == NULL) || (lo > hi)) return 0;
+    return _intIntervalVisit(itree->_tree->_root, lo, hi, fn, ctx);
+}
+
+/* Calls a function on each interval that contains the given point, like
+ * intIntervalOverlap.
+ * Returns the number of intervals found.
+ */
+unsigned long int intIntervalStab(AVLIntIntervalTree *itree, int point,
+                                  void (*fn)(AVLIntInterval *interval,
+                                             void *ctx),
+                                  void *ctx) {
+    return intIntervalOverlap(itree, point, point, fn, ctx);
+}
+
+// INTERNAL LIBRARY SUBROUTINES //
+/* Summarizes a single interval with its upper end. */
+void _intIntervalEntry(void *aug, int key, void *data, void *ctx) {
+    (void) key;
+    (void) ctx;
+    *((int *) aug) = ((AVLIntInterval *) data)->hi;
+}
+
+/* Combines two summaries, taking the greatest upper end. */
+void _intIntervalCombine(void *aug, const void *aug1, const void *aug2,
+                         void *ctx) {
+    (void) ctx;
+    int hi1 = *((const int *) aug1);
+    int hi2 = *((const int *) aug2);
+    *((int *) aug) = hi1 >= hi2 ? hi1 : hi2;
+}
+
+/* Returns the node that holds an interval with the given ends in a subtree,
+ * or NULL. Intervals with the same lower end may be on both sides of each
+ * other after rotations, so both sons of a matching node are looked into.
+ */
+AVLIntNode *_intIntervalFind(AVLIntNode *node, int lo, int hi) {
+    AVLIntNode *found;
+    while (node != NULL) {
+        if (node->_key > lo) {
+            node = node->_leftSon;
+        } else if (node->_key < lo) {
+            node = node->_rightSon;
+        } else {
+            if (((AVLIntInterval *) node->_data)->hi == hi) return node;
+            found = _intIntervalFind(node->_leftSon, lo, hi);
+            if (found != NULL) return found;
+            node = node->_rightSon;
+        }
+    }
+    return NULL;
+}
+
+/* Calls a function on each interval in a subtree that overlaps the one from lo
+ * to hi, in order, skipping the subtrees in which they all end before lo and
+ * those in which they all start after hi.
+ * Returns the number of intervals found.
+ */
+unsigned long int _intIntervalVisit(AVLIntNode *node, int lo, int hi,
+                                    void (*fn)(AVLIntInterval *interval,
+                                               void *ctx),
+                                    void *ctx) {
+    unsigned long int found = 0;
+    AVLIntInterval *interval;
+    while ((node != NULL) && (MAX_HI(node) >= lo)) {
+        found += _intIntervalVisit(node->_leftSon, lo, hi, fn, ctx);
+        // This one, and those on its right, start after hi.
+        if (node->_key > hi) break;
+        interval = (AVLIntInterval *) node->_data;
+        if (interval->hi >= lo) {
+            fn(interval, ctx);
+            found++;
+        }
+        node = node->_rightSon;
+    }
+    return found;
+}
@@ -0,0 +1,53 @@
+/* AVL Trees library contributors
+ * Creation Date: 17/10/2026
+ * Latest Version: 17/10/2026
+ * ----------------------------------------------------------------------------
+ * This file contains type definitions and declarations for the interval trees
+ * built on the AVL Trees with integer keys. See the source file for brief
+ * descriptions of what each function does. Note that functions which names
+ * start with "_" are meant for internal use only, and only those without it
+ * should be used by the actual programmer.
+ */
+/* This code is released under the MIT license.
+ * See the attached LICENSE file.
+ */
+
+#ifndef AVLTREES_INTEGERKEYS_INTERVALS_H
+#define AVLTREES_INTEGERKEYS_INTERVALS_H
+
+#include "AVLTree_IntegerKeys.h"
+
+/* An interval goes from lo to hi, both included, and carries some data, which
+ * can be everything, as long as it's at most 64-bits wide.
+ */
+typedef struct {
+    int lo;
+    int hi;
+    void *data;
+} AVLIntInterval;
+
+/* An interval tree keeps its intervals in an AVL tree, ordered by their lower
+ * ends, in which each node is augmented with the greatest upper end found in
+ * its subtree. The inner tree must only be accessed through these functions.
+ */
+typedef struct {
+    AVLIntTree *_tree;
+    unsigned long int intervalsCount;
+} AVLIntIntervalTree;
+
+/* Library functions. */
+AVLIntIntervalTree *createIntIntervalTree(void);
+int deleteIntIntervalTree(AVLIntIntervalTree *itree, int opts);
+unsigned long int intIntervalInsert(AVLIntIntervalTree *itree, int lo, int hi,
+                                    void *data);
+int intIntervalDelete(AVLIntIntervalTree *itree, int lo, int hi, int opts);
+unsigned long int intIntervalOverlap(AVLIntIntervalTree *itree, int lo, int hi,
+                                     void (*fn)(AVLIntInterval *interval,
+                                                void *ctx),
+                                     void *ctx);
+unsigned long int intIntervalStab(AVLIntIntervalTree *itree, int point,
+                                  void (*fn)(AVLIntInterval *interval,
+                                             void *ctx),
+                                  void *ctx);
+
+#endif
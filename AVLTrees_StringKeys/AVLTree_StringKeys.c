@@ -1,6 +1,6 @@
 /* Roberto Masocco
  * Creation Date: 6/8/2018
- * Latest Version: 26/7/2019
+ * Latest Version: 17/10/2026
  * ----------------------------------------------------------------------------
  * This is the main source file for the AVL Trees library.
  * See the comments above each function definition for information about what
@@ -14,36 +14,178 @@
 #include <stdlib.h>
 #include <string.h>
 #include <limits.h>
+#include <stdint.h>
 #include "AVLTree_StringKeys.h"
 
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
 /* Macro to find the maximum between two integers. */
 #define MAX(X, Y) ((X) <= (Y) ? (Y) : (X))
 
+/* Macro to get the number of bytes taken by an entry with a given key: that of
+ * its node and of the key.
+ */
+#define ENTRY_BYTES(KEY) (sizeof(AVLStrNode) + strlen(KEY) + 1)
+
+/* Smallest page size, which bounds how far past its end a string can be read
+ * in blocks without touching a page that might not be mapped.
+ */
+#define MIN_PAGE_SIZE 4096
+
+/* Number of subtrees handed to each worker in parallel breadth-first visits:
+ * more than one lets workers that got smaller subtrees pick up some more work.
+ */
+#define PAR_TASKS_PER_THREAD 8
+
+/* Shared state of a parallel visit: the result array, the kind of visit and
+ * the size above which a subtree is worth a new task.
+ * Breadth-first visits also need the subtrees found at a cut depth, each
+ * visited by a task, and a matrix of offsets with a row for the top of the
+ * tree plus one for each subtree, and a column for each level, which are used
+ * first as counters and then as write cursors.
+ */
+typedef struct {
+    void *_res;
+    int _type;
+    int _intOpt;
+    unsigned long int _grain;
+    int _cutDepth;
+    int _levels;
+    int _store;
+    AVLStrNode **_roots;
+    unsigned long int *_offsets;
+    unsigned long int _nTasks;
+} AVLStrParVisit;
+
+/* A step of a parallel depth-first visit: a subtree, and the position of its
+ * first entry in the result.
+ */
+typedef struct {
+    AVLStrParVisit *_visit;
+    AVLStrNode *_node;
+    unsigned long int _offset;
+} AVLStrParStep;
+
+/* A key and its data, as sorted while building a tree. */
+typedef struct {
+    char *_key;
+    void *_data;
+} AVLStrPair;
+
+/* Shared state of a parallel build: the input, the entries as they are being
+ * sorted, the bounds of the sorted runs that the merge sort has to merge, and
+ * the size above which a subtree is worth a new task.
+ * Each merge of two runs is split in the given number of parts, so that all
+ * workers have something to do even when only a few runs are left.
+ */
+typedef struct {
+    char **_keys;
+    void **_data;
+    AVLStrPair *_pairs;
+    AVLStrPair *_tmp;
+    unsigned long int _n;
+    unsigned long int _nChunks;
+    unsigned long int *_bounds;
+    unsigned long int _nRuns;
+    unsigned long int _parts;
+    int _failed;
+    unsigned long int _grain;
+} AVLStrParBuild;
+
+/* A subtree to be built from a range of the sorted entries, and the place in
+ * which it has to be attached.
+ */
+typedef struct {
+    AVLStrParBuild *_build;
+    AVLStrNode *_father;
+    AVLStrNode **_slot;
+    unsigned long int _lo;
+    unsigned long int _hi;
+} AVLStrBuildStep;
+
+/* Shared state of a parallel fold of the tree's entries, either to call a
+ * function on each of them or to reduce them to a single value, and the size
+ * above which a subtree is worth a new task.
+ */
+typedef struct {
+    void (*_forEach)(char *key, void *data, void *ctx);
+    void *(*_reduce)(void *acc, char *key, void *data, void *ctx);
+    void *(*_combine)(void *acc1, void *acc2, void *ctx);
+    void *_identity;
+    void *_ctx;
+    unsigned long int _grain;
+} AVLStrParFold;
+
+/* A step of a parallel fold: a subtree, and its partial result. */
+typedef struct {
+    AVLStrParFold *_fold;
+    AVLStrNode *_node;
+    void *_acc;
+} AVLStrFoldStep;
+
 /* Internal library subroutines declarations. */
 AVLStrNode *_createStrNode(char *newKey, void *newData);
 void _deleteStrNode(AVLStrNode *node);
 AVLStrNode *_searchStrNode(AVLStrTree *tree, char *key);
+void _strInsertNode(AVLStrTree *tree, AVLStrNode *newNode);
+unsigned long long int _strNormalize(AVLStrTree *tree, char *key);
+int _strCompare(AVLStrTree *tree, AVLStrNode *node, char *key,
+                unsigned long long int norm, unsigned long int *lo,
+                unsigned long int *hi);
+unsigned long int _strMismatch(const char *key1, const char *key2,
+                               unsigned long int from);
 void _strInsertAsLeftSubtree(AVLStrNode *father, AVLStrNode *newSon);
 void _strInsertAsRightSubtree(AVLStrNode *father, AVLStrNode *newSon);
 AVLStrNode *_strCutLeftSubtree(AVLStrNode *father);
 AVLStrNode *_strCutRightSubtree(AVLStrNode *father);
 AVLStrNode *_strCutSubtree(AVLStrNode *node);
 AVLStrNode *_strMaxKeySon(AVLStrNode *node);
-AVLStrNode *_strCutOneSonNode(AVLStrNode *node);
+void _strReplaceSubtree(AVLStrTree *tree, AVLStrNode *node,
+                        AVLStrNode *newNode);
+void _strDeleteNode(AVLStrTree *tree, AVLStrNode *node);
 int _strHeight(AVLStrNode *node);
+unsigned long int _strSize(AVLStrNode *node);
 void _strSetHeight(AVLStrNode *node, int newHeight);
-void _strSwapInfo(AVLStrNode *node1, AVLStrNode *node2);
 int _strBalanceFactor(AVLStrNode *node);
 void _strUpdateHeight(AVLStrNode *node);
-void _strRightRotation(AVLStrNode *node);
-void _strLeftRotation(AVLStrNode *node);
-void _strRotate(AVLStrNode *node);
-void _strBalanceInsert(AVLStrNode *newNode);
-void _strBalanceDelete(AVLStrNode *remFather);
+void _strRightRotation(AVLStrTree *tree, AVLStrNode *node);
+void _strLeftRotation(AVLStrTree *tree, AVLStrNode *node);
+AVLStrNode *_strRotate(AVLStrTree *tree, AVLStrNode *node);
+void _strBalanceInsert(AVLStrTree *tree, AVLStrNode *newNode);
+void _strBalanceDelete(AVLStrTree *tree, AVLStrNode *remFather);
+unsigned long int _strCacheSlot(AVLStrTree *tree, char *key);
+void _strCacheForget(AVLStrTree *tree, AVLStrNode *node);
+int _strCharge(AVLStrTree *tree, unsigned long int bytes, int quiet);
+void _strRelease(AVLStrTree *tree, unsigned long int bytes);
+int _strMoveCharge(AVLStrTree *from, AVLStrTree *to,
+                   unsigned long int bytes);
 void _strInODFS(AVLStrNode *rootNode, void ***intPtr, int intOpt);
 void _strPreODFS(AVLStrNode *rootNode, void ***intPtr, int intOpt);
 void _strPostODFS(AVLStrNode *rootNode, void ***intPtr, int intOpt);
-
+void *_strAllocVisit(unsigned long int count, int opts, int *intOpt);
+void _strStoreEntry(void *res, unsigned long int pos, AVLStrNode *node,
+                    int intOpt);
+int _strCutDepth(int height, int nthreads);
+void _strDFSAt(AVLStrParVisit *visit, AVLStrNode *node,
+               unsigned long int offset);
+void _strParDFS(void *arg);
+void _strLevelVisit(AVLStrParVisit *visit, AVLStrNode *node, int depth,
+                    unsigned long int row);
+void _strParBFSSplit(AVLStrParVisit *visit, AVLStrNode *node, int depth);
+void _strParBFSTask(void *arg, unsigned long int task);
+int _strComparePairs(const void *pair1, const void *pair2);
+void _strParSortTask(void *arg, unsigned long int chunk);
+unsigned long int _strCoRank(AVLStrPair *run1, unsigned long int len1,
+                             AVLStrPair *run2, unsigned long int len2,
+                             unsigned long int rank);
+void _strParMergeTask(void *arg, unsigned long int task);
+int _strBuildHeight(unsigned long int count);
+void _strParBuild(void *arg);
+void _strFreeSubtree(AVLStrNode *node);
+void *_strFold(AVLStrParFold *fold, AVLStrNode *node, void *acc);
+void _strParFold(void *arg);
 
 // USER FUNCTIONS //
 /* Creates a new AVL Tree in the heap. */
@@ -53,6 +195,15 @@ AVLStrTree *createStrTree(void) {
     newTree->_root = NULL;
     newTree->nodesCount = 0;
     newTree->maxNodes = ULONG_MAX;
+    newTree->_cache = NULL;
+    newTree->_cacheBits = 0;
+    newTree->cacheHits = 0;
+    newTree->cacheMisses = 0;
+    newTree->_normalize = NULL;
+    newTree->_normCtx = NULL;
+    newTree->_skipPrefixes = 0;
+    newTree->memUsed = sizeof(AVLStrTree);
+    newTree->_budget = NULL;
     return newTree;
 }
 
@@ -64,6 +215,9 @@ int deleteStrTree(AVLStrTree *tree, int opts) {
     // Sanity check on input arguments.
     if (tree == NULL) return -1;
     if (opts < 0) return -1;
+    // Everything the tree is using goes back to its budget.
+    memBudgetRelease(tree->_budget, tree->memUsed);
+    free(tree->_cache);
     // If the tree is empty free it directly.
     if (tree->_root == NULL) {
         free(tree);
@@ -86,7 +240,8 @@ int deleteStrTree(AVLStrTree *tree, int opts) {
 
 /* Searches for an entry with the specified key in the tree. */
 void *strSearch(AVLStrTree *tree, char *key, int opts) {
-    if ((opts <= 0) || (tree == NULL)) return NULL;  // Sanity check.
+    // Sanity check on input arguments.
+    if ((opts <= 0) || (key == NULL) || (tree == NULL)) return NULL;
     AVLStrNode *searchedNode = _searchStrNode(tree, key);
     if (searchedNode != NULL) {
         if (opts & SEARCH_DATA) return searchedNode->_data;
@@ -101,66 +256,160 @@ int strDelete(AVLStrTree *tree, char *key, int opts) {
     // Sanity check on input arguments.
     if ((opts < 0) || (key == NULL) || (tree == NULL)) return 0;
     AVLStrNode *toDelete = _searchStrNode(tree, key);
-    AVLStrNode *toFree;
     if (toDelete != NULL) {
-        // Check whether the node has no sons or even one.
-        if ((toDelete->_leftSon == NULL) || (toDelete->_rightSon == NULL)) {
-            toFree = _strCutOneSonNode(toDelete);
-        } else {
-            // Find the node's predecessor and swap the content.
-            AVLStrNode *maxLeft = _strMaxKeySon(toDelete->_leftSon);
-            _strSwapInfo(toDelete, maxLeft);
-            // Remove the original predecessor.
-            toFree = _strCutOneSonNode(maxLeft);
-        }
+        // Unlink the node, then forget about it.
+        _strDeleteNode(tree, toDelete);
+        _strCacheForget(tree, toDelete);
+        _strRelease(tree, ENTRY_BYTES(toDelete->_key));
         // Apply eventual options to free keys and data, then free the node.
-        if (opts & DELETE_FREE_DATA) free(toFree->_data);
-        if (opts & DELETE_FREE_KEYS) free(toFree->_key);
-        free(toFree);
+        if (opts & DELETE_FREE_DATA) free(toDelete->_data);
+        if (opts & DELETE_FREE_KEYS) free(toDelete->_key);
+        _deleteStrNode(toDelete);
         tree->nodesCount--;
-        // Check if the tree is now empty and update root pointer.
-        if (tree->nodesCount == 0) tree->_root = NULL;
         return 1;  // Found and deleted.
     }
     return 0;  // Not found.
 }
 
-/* Creates and inserts a new node in the tree. */
+/* Creates and inserts a new node in the tree, charging it and its key to the
+ * tree's budget, if it has one.
+ * Returns the new number of entries, or 0 if the insertion failed or the
+ * budget refused it.
+ */
 unsigned long int strInsert(AVLStrTree *tree, char *newKey, void *newData) {
     if ((newKey == NULL) || (tree == NULL)) return 0;  // Sanity check.
     if (tree->nodesCount == tree->maxNodes) return 0;  // The tree is full.
+    if (_strCharge(tree, ENTRY_BYTES(newKey), 0) != 0) return 0;
     AVLStrNode *newNode = _createStrNode(newKey, newData);
-    if (tree->_root == NULL) {
-        // The tree is empty.
-        tree->_root = newNode;
-        tree->nodesCount++;
-    } else {
-        // Look for the correct position and place it there.
-        AVLStrNode *curr = tree->_root;
-        AVLStrNode *pred = NULL;
-        int comp;
-        while (curr != NULL) {
-            pred = curr;
-            comp = strcmp(curr->_key, newKey);
-            if (comp >= 0) {
-                // Equals are kept in the left subtree.
-                curr = curr->_leftSon;
-            } else {
-                curr = curr->_rightSon;
-            }
-        }
-        comp = strcmp(pred->_key, newKey);
-        if (comp >= 0) {
-            _strInsertAsLeftSubtree(pred, newNode);
-        } else {
-            _strInsertAsRightSubtree(pred, newNode);
-        }
-        _strBalanceInsert(newNode);
-        tree->nodesCount++;
+    if (newNode == NULL) {
+        _strRelease(tree, ENTRY_BYTES(newKey));
+        return 0;
     }
+    _strInsertNode(tree, newNode);
     return tree->nodesCount;  // Return the result of the insertion.
 }
 
+/* Charges the memory used by the tree to a budget, which can be shared with
+ * other trees, moving it from the one it had, if any, or removes the tree from
+ * its budget if it's NULL. The tree is charged all its memory even if that
+ * exceeds the budget's limit, but then it can't grow until there's room.
+ * Operations that make the tree grow call the budget's pressure callback when
+ * needed: it may delete entries from any tree, this one included, but must
+ * not insert any, nor change the trees' settings.
+ * Returns 0 if successful, -1 otherwise.
+ */
+int strSetBudget(AVLStrTree *tree, AVLMemBudget *budget) {
+    if (tree == NULL) return -1;  // Sanity check.
+    memBudgetRelease(tree->_budget, tree->memUsed);
+    memBudgetForce(budget, tree->memUsed);
+    tree->_budget = budget;
+    return 0;
+}
+
+/* Gives the tree a direct-mapped cache of the nodes found by searches, with
+ * the given number of slots (rounded up to a power of two, up to
+ * 2^CACHE_MAX_BITS), or removes it if the size is zero. Each key can only be
+ * cached in one slot, so searching it again costs a hash and a single
+ * comparison as long as no other key took its slot. Hits and misses are
+ * counted in the tree, and reset by this call.
+ * Concurrent searches remain safe, since the cache is updated atomically.
+ * Returns 0 if successful, -1 if memory could not be allocated or the tree's
+ * budget refused it.
+ */
+int strSetCache(AVLStrTree *tree, unsigned long int size) {
+    if (tree == NULL) return -1;  // Sanity check.
+    AVLStrNode **newCache = NULL;
+    int bits = 0;
+    if (size > 0) {
+        while (((1UL << bits) < size) && (bits < CACHE_MAX_BITS))
+            bits++;
+        if (bits == 0) bits = 1;
+        if (_strCharge(tree, (1UL << bits) * sizeof(AVLStrNode *), 0) != 0)
+            return -1;
+        newCache = (AVLStrNode **) calloc(1UL << bits, sizeof(AVLStrNode *));
+        if (newCache == NULL) {
+            _strRelease(tree, (1UL << bits) * sizeof(AVLStrNode *));
+            return -1;
+        }
+    }
+    if (tree->_cache != NULL)
+        _strRelease(tree, (1UL << tree->_cacheBits) * sizeof(AVLStrNode *));
+    free(tree->_cache);
+    tree->_cache = newCache;
+    tree->_cacheBits = bits;
+    tree->cacheHits = 0;
+    tree->cacheMisses = 0;
+    return 0;
+}
+
+/* Makes the tree normalize its keys with the given function, which receives
+ * ctx too, or stops normalizing them if it's NULL. This can only be done while
+ * the tree is empty.
+ * Entries are ordered by their normalized keys first, so comparing two keys
+ * costs an integer comparison whenever those differ, and by the keys
+ * themselves only when they don't. The function can be anything, as long as
+ * it always gives the same result for the same key: if it preserves the order
+ * of the keys (e.g. turns fixed-width numbers into their values) visits return
+ * keys in the usual order, else they follow that of the normalized keys.
+ * strKeyPrefix gives the first 8 bytes of each key, for keys that don't share
+ * them too often: the rest of the keys is compared only when those match.
+ * strKeyHash gives a hash of each key, for trees that are only searched for
+ * exact keys: descents compare integers until they get to the key, whatever
+ * its length, but visits return keys in no meaningful order.
+ * Returns 0 if successful, -1 if the tree is not empty.
+ */
+int strSetNormalizer(AVLStrTree *tree,
+                     unsigned long long int (*normalize)(const char *key,
+                                                         void *ctx),
+                     void *ctx) {
+    if (tree == NULL) return -1;  // Sanity check.
+    if (tree->nodesCount > 0) return -1;
+    tree->_normalize = normalize;
+    tree->_normCtx = normalize != NULL ? ctx : NULL;
+    return 0;
+}
+
+/* Makes searches and insertions skip, in each comparison, the bytes that the
+ * key looked for is known to share with the one it's compared with, or stops
+ * them from doing it. Those are the bytes it shares with both the greatest key
+ * it was found to follow and the smallest it was found to precede, since every
+ * key in between shares them too.
+ * This pays off when keys share long prefixes (e.g. paths, or URLs), which
+ * would be compared again and again along the way. It has no effect while the
+ * tree normalizes its keys.
+ * Returns 0 if successful, -1 otherwise.
+ */
+int strSetPrefixSkip(AVLStrTree *tree, int enable) {
+    if (tree == NULL) return -1;  // Sanity check.
+    tree->_skipPrefixes = enable ? 1 : 0;
+    return 0;
+}
+
+/* Normalizes a key into its first 8 bytes, padded with zeros, as an integer in
+ * which the first byte is the most significant one, so that the order of the
+ * keys is preserved. Meant to be given to strSetNormalizer.
+ */
+unsigned long long int strKeyPrefix(const char *key, void *ctx) {
+    (void) ctx;
+    unsigned long long int prefix = 0;
+    for (int i = 0; i < 8; i++) {
+        prefix <<= 8;
+        if (*key != '\0') prefix |= (unsigned char) *(key++);
+    }
+    return prefix;
+}
+
+/* Normalizes a key into a 64-bit FNV-1a hash of all its bytes. Meant to be
+ * given to strSetNormalizer.
+ */
+unsigned long long int strKeyHash(const char *key, void *ctx) {
+    (void) ctx;
+    unsigned long long int hash = 14695981039346656037ULL;
+    for (const unsigned char *c = (const unsigned char *) key; *c != '\0'; c++)
+        hash = (hash ^ *c) * 1099511628211ULL;
+    return hash;
+}
+
 /* Performs a depth-first search of the tree, the type of which can be
  * specified using the options defined in the header.
  * Depending on the option specified, returns an array of:
@@ -272,6 +521,352 @@ void **strBFS(AVLStrTree *tree, int type, int opts) {
     return bfsRes;
 }
 
+/* Performs a depth-first search of the tree like strDFS, splitting the work
+ * among the workers of the given pool.
+ * Every subtree bigger than the pool's grain has its left son visited by a
+ * new task, and each task writes directly into its own portion of the result
+ * array, found using the subtree sizes stored in the nodes.
+ * Options and types are the same accepted by strDFS. If the pool is NULL, this
+ * is just strDFS.
+ * Remember to free the returned array afterwards!
+ */
+void **strParallelDFS(AVLStrTree *tree, int type, int opts,
+                      AVLWorkPool *pool) {
+    // Sanity check for the input arguments.
+    if ((type <= 0) || (opts <= 0)) return NULL;
+    if ((tree == NULL) || (tree->_root == NULL)) return NULL;
+    if (pool == NULL) return strDFS(tree, type, opts);
+    AVLStrParVisit visit;
+    if (type & DFS_PRE_ORDER) {
+        visit._type = DFS_PRE_ORDER;
+    } else if (type & DFS_IN_ORDER) {
+        visit._type = DFS_IN_ORDER;
+    } else if (type & DFS_POST_ORDER) {
+        visit._type = DFS_POST_ORDER;
+    } else return NULL;  // Invalid type.
+    // Allocate memory according to options.
+    visit._res = _strAllocVisit(tree->nodesCount, opts, &(visit._intOpt));
+    if (visit._res == NULL) return NULL;
+    visit._grain = pool->grain;
+    AVLStrParStep step = {&visit, tree->_root, 0};
+    workPoolRun(pool, _strParDFS, &step);
+    return (void **) (visit._res);
+}
+
+/* Performs a breadth-first search of the tree like strBFS, splitting the work
+ * among the workers of the given pool.
+ * The tree is cut at a depth that gives enough subtrees to keep all workers
+ * busy. Each subtree's nodes on each level are counted first, then the offsets
+ * at which each subtree must write its nodes on every level are computed, and
+ * at last the subtrees are visited again writing the results. Since a
+ * depth-first visit meets the nodes of a same level in the order in which a
+ * breadth-first one would, no queue is needed.
+ * Options and types are the same accepted by strBFS. If the pool is NULL, this
+ * is just strBFS.
+ * The subtrees and the offsets are charged to the tree's budget, if it has
+ * one, while the visit runs: the visit fails if the budget refuses them.
+ * Remember to free the returned array afterwards!
+ */
+void **strParallelBFS(AVLStrTree *tree, int type, int opts,
+                      AVLWorkPool *pool) {
+    // Sanity check on input arguments.
+    if ((tree == NULL) || (tree->_root == NULL) ||
+        (type <= 0) || (opts <= 0) ||
+        !((type & BFS_LEFT_FIRST) || (type & BFS_RIGHT_FIRST)) ||
+        !((opts & SEARCH_KEYS) || (opts & SEARCH_DATA) ||
+        (opts & SEARCH_NODES))) return NULL;
+    if (pool == NULL) return strBFS(tree, type, opts);
+    AVLStrParVisit visit;
+    visit._type = (type & BFS_LEFT_FIRST) ? BFS_LEFT_FIRST : BFS_RIGHT_FIRST;
+    visit._res = _strAllocVisit(tree->nodesCount, opts, &(visit._intOpt));
+    if (visit._res == NULL) return NULL;
+    visit._cutDepth = _strCutDepth(tree->_root->_height, pool->nthreads);
+    visit._levels = tree->_root->_height + 1;
+    unsigned long int scratch = (1UL << visit._cutDepth) *
+                                sizeof(AVLStrNode *) +
+                                ((1UL << visit._cutDepth) + 1) *
+                                visit._levels * sizeof(unsigned long int);
+    if (_strCharge(tree, scratch, 1) != 0) {
+        free(visit._res);
+        return NULL;
+    }
+    visit._roots = calloc(1UL << visit._cutDepth, sizeof(AVLStrNode *));
+    visit._offsets = calloc(((1UL << visit._cutDepth) + 1) * visit._levels,
+                            sizeof(unsigned long int));
+    if ((visit._roots == NULL) || (visit._offsets == NULL)) {
+        free(visit._roots);
+        free(visit._offsets);
+        free(visit._res);
+        _strRelease(tree, scratch);
+        return NULL;
+    }
+    // Collect the subtrees and count the nodes on each level.
+    visit._nTasks = 0;
+    visit._store = 0;
+    _strParBFSSplit(&visit, tree->_root, 0);
+    _strLevelVisit(&visit, tree->_root, 0, 0);
+    workPoolFor(pool, _strParBFSTask, &visit, visit._nTasks);
+    // Turn the counters into write cursors: levels come one after the other,
+    // and on each level the top of the tree comes before the subtrees, which
+    // are sorted as the visit requires.
+    unsigned long int next = 0, count;
+    for (int level = 0; level < visit._levels; level++) {
+        for (unsigned long int row = 0; row <= visit._nTasks; row++) {
+            count = visit._offsets[row * visit._levels + level];
+            visit._offsets[row * visit._levels + level] = next;
+            next += count;
+        }
+    }
+    // Visit everything again, this time storing the results.
+    visit._store = 1;
+    _strLevelVisit(&visit, tree->_root, 0, 0);
+    workPoolFor(pool, _strParBFSTask, &visit, visit._nTasks);
+    free(visit._roots);
+    free(visit._offsets);
+    _strRelease(tree, scratch);
+    return (void **) (visit._res);
+}
+
+/* Builds a new tree from arrays of keys and data, which don't need to be
+ * sorted, splitting the work among the workers of the given pool.
+ * The entries are sorted with a parallel merge sort, then the tree is built
+ * perfectly balanced, with every subtree bigger than the pool's grain having
+ * its left son built by a new task.
+ * As usual, keys are not copied, so the strings must stay where they are.
+ * Data can be NULL, in which case all entries will have NULL data. If the pool
+ * is NULL, everything is done sequentially.
+ * Returns the new tree, or NULL if memory could not be allocated.
+ */
+AVLStrTree *strBuildParallel(char **keys, void **data, unsigned long int n,
+                             AVLWorkPool *pool) {
+    // Sanity check on input arguments.
+    if ((keys == NULL) && (n > 0)) return NULL;
+    for (unsigned long int i = 0; i < n; i++) if (keys[i] == NULL) return NULL;
+    AVLStrTree *newTree = createStrTree();
+    if ((newTree == NULL) || (n == 0)) return newTree;
+    unsigned long int nthreads = (pool != NULL) ?
+                                 (unsigned long int) pool->nthreads : 1;
+    AVLStrParBuild build;
+    build._keys = keys;
+    build._data = data;
+    build._n = n;
+    build._nChunks = (nthreads < n) ? nthreads : n;
+    build._grain = (pool != NULL) ? pool->grain : ULONG_MAX;
+    build._failed = 0;
+    build._pairs = (AVLStrPair *) calloc(n, sizeof(AVLStrPair));
+    build._tmp = (AVLStrPair *) calloc(n, sizeof(AVLStrPair));
+    build._bounds = (unsigned long int *) calloc(build._nChunks + 1,
+                                                 sizeof(unsigned long int));
+    if ((build._pairs == NULL) || (build._tmp == NULL) ||
+        (build._bounds == NULL)) {
+        free(build._pairs);
+        free(build._tmp);
+        free(build._bounds);
+        free(newTree);
+        return NULL;
+    }
+    // Sort each chunk of the input, then merge the sorted runs in pairs until
+    // only one is left.
+    for (unsigned long int chunk = 0; chunk <= build._nChunks; chunk++)
+        build._bounds[chunk] = chunk * n / build._nChunks;
+    build._nRuns = build._nChunks;
+    workPoolFor(pool, _strParSortTask, &build, build._nChunks);
+    AVLStrPair *swap;
+    unsigned long int merges;
+    while (build._nRuns > 1) {
+        merges = (build._nRuns + 1) / 2;
+        build._parts = (nthreads + merges - 1) / merges;
+        workPoolFor(pool, _strParMergeTask, &build, merges * build._parts);
+        for (unsigned long int run = 0; run < merges; run++)
+            build._bounds[run] = build._bounds[2 * run];
+        build._bounds[merges] = n;
+        build._nRuns = merges;
+        swap = build._pairs;
+        build._pairs = build._tmp;
+        build._tmp = swap;
+    }
+    free(build._tmp);
+    free(build._bounds);
+    // Build the tree.
+    AVLStrBuildStep step = {&build, NULL, &(newTree->_root), 0, n};
+    workPoolRun(pool, _strParBuild, &step);
+    free(build._pairs);
+    if (build._failed) {
+        _strFreeSubtree(newTree->_root);
+        free(newTree);
+        return NULL;
+    }
+    newTree->nodesCount = n;
+    for (unsigned long int i = 0; i < n; i++)
+        newTree->memUsed += ENTRY_BYTES(keys[i]);
+    return newTree;
+}
+
+/* Calls the given function on each entry of the tree, passing it the key, the
+ * data and the specified context, splitting the work among the workers of the
+ * given pool.
+ * Every subtree bigger than the pool's grain has its left son visited by a
+ * new task, so calls can happen concurrently and in any order. If the pool is
+ * NULL, the entries are visited sequentially, in order.
+ * Returns 0 if successful, -1 otherwise.
+ */
+int strParallelForEach(AVLStrTree *tree,
+                       void (*fn)(char *key, void *data, void *ctx),
+                       void *ctx, AVLWorkPool *pool) {
+    // Sanity check on input arguments.
+    if ((tree == NULL) || (fn == NULL)) return -1;
+    AVLStrParFold fold = {fn, NULL, NULL, NULL, ctx,
+                          (pool != NULL) ? pool->grain : ULONG_MAX};
+    AVLStrFoldStep step = {&fold, tree->_root, NULL};
+    workPoolRun(pool, _strParFold, &step);
+    return 0;
+}
+
+/* Reduces the entries of the tree to a single value, splitting the work among
+ * the workers of the given pool.
+ * Starting from the identity value, the reduce function adds an entry to an
+ * accumulated value and returns the result, while the combine function merges
+ * two accumulated values into one. Subtrees are reduced by different tasks,
+ * then partial results are combined following the order of the keys, so the
+ * combine function needs to be associative but not commutative, and the
+ * identity must be neutral for it. If the pool is NULL, the entries are just
+ * reduced sequentially.
+ * Returns the reduced value, which is the identity for an empty tree.
+ */
+void *strParallelReduce(AVLStrTree *tree,
+                        void *(*reduce)(void *acc, char *key, void *data,
+                                        void *ctx),
+                        void *(*combine)(void *acc1, void *acc2, void *ctx),
+                        void *identity, void *ctx, AVLWorkPool *pool) {
+    // Sanity check on input arguments.
+    if ((tree == NULL) || (reduce == NULL) || (combine == NULL))
+        return identity;
+    AVLStrParFold fold = {NULL, reduce, combine, identity, ctx,
+                          (pool != NULL) ? pool->grain : ULONG_MAX};
+    AVLStrFoldStep step = {&fold, tree->_root, identity};
+    workPoolRun(pool, _strParFold, &step);
+    return step._acc;
+}
+
+/* Starts migrating the entries of a tree into another one, moving up to step
+ * of them (at least one) at each operation.
+ * Returns a new migration in the heap, or NULL if it could not be allocated.
+ */
+AVLStrMigration *strStartMigration(AVLStrTree *from, AVLStrTree *to,
+                                   unsigned long int step) {
+    // Sanity check on input arguments.
+    if ((from == NULL) || (to == NULL) || (from == to)) return NULL;
+    AVLStrMigration *newMig = (AVLStrMigration *) malloc(
+            sizeof(AVLStrMigration));
+    if (newMig == NULL) return NULL;
+    newMig->_from = from;
+    newMig->_to = to;
+    newMig->_step = (step > 0) ? step : 1;
+    return newMig;
+}
+
+/* Searches for an entry with the specified key in either tree, like
+ * strSearch.
+ */
+void *strMigrationSearch(AVLStrMigration *mig, char *key, int opts) {
+    // Sanity check on input arguments.
+    if ((opts <= 0) || (key == NULL) || (mig == NULL)) return NULL;
+    strMigrationStep(mig, mig->_step);
+    AVLStrNode *searchedNode = _searchStrNode(mig->_to, key);
+    if (searchedNode == NULL) searchedNode = _searchStrNode(mig->_from, key);
+    if (searchedNode != NULL) {
+        if (opts & SEARCH_DATA) return searchedNode->_data;
+        if (opts & SEARCH_NODES) return searchedNode;
+        return NULL;
+    }
+    return NULL;
+}
+
+/* Inserts a new entry in the new tree, like strInsert.
+ * Returns the new number of entries in both trees, or 0 if the insertion
+ * failed.
+ */
+unsigned long int strMigrationInsert(AVLStrMigration *mig, char *newKey,
+                                     void *newData) {
+    if (mig == NULL) return 0;  // Sanity check.
+    strMigrationStep(mig, mig->_step);
+    if (strInsert(mig->_to, newKey, newData) == 0) return 0;
+    return mig->_from->nodesCount + mig->_to->nodesCount;
+}
+
+/* Deletes an entry with the specified key from whichever tree it's in, like
+ * strDelete.
+ * Returns 1 if it was found and deleted, 0 otherwise.
+ */
+int strMigrationDelete(AVLStrMigration *mig, char *key, int opts) {
+    if (mig == NULL) return 0;  // Sanity check.
+    strMigrationStep(mig, mig->_step);
+    if (strDelete(mig->_to, key, opts)) return 1;
+    return strDelete(mig->_from, key, opts);
+}
+
+/* Moves up to count entries from the old tree to the new one, without
+ * allocating anything: each node is unlinked from the old tree and linked into
+ * the new one, which is charged for it first, and the old one gives it back.
+ * The moves stop early if the new tree is full, or its budget (when it's not
+ * the same of the old tree) refuses them. Can be called when there's time to
+ * spare, to finish the migration sooner.
+ * Returns the number of entries still to be moved.
+ */
+unsigned long int strMigrationStep(AVLStrMigration *mig,
+                                   unsigned long int count) {
+    if (mig == NULL) return 0;  // Sanity check.
+    AVLStrTree *from = mig->_from;
+    AVLStrNode *node;
+    while ((count > 0) && (from->_root != NULL) &&
+           (mig->_to->nodesCount < mig->_to->maxNodes)) {
+        // The greatest node has no right son, so it's quick to unlink.
+        node = _strMaxKeySon(from->_root);
+        if (_strMoveCharge(from, mig->_to, ENTRY_BYTES(node->_key)) != 0)
+            break;
+        _strDeleteNode(from, node);
+        _strCacheForget(from, node);
+        from->nodesCount--;
+        node->_father = NULL;
+        node->_leftSon = NULL;
+        node->_rightSon = NULL;
+        node->_height = 0;
+        node->_size = 1;
+        _strInsertNode(mig->_to, node);
+        count--;
+    }
+    return from->nodesCount;
+}
+
+/* Moves all the entries still in the old tree, which is then freed along with
+ * the migration, so that the new tree can be used directly again.
+ * Returns 0 if successful, -1 if the entries could not all be moved (e.g. if
+ * the new tree got full): the migration is then still going on, and can be
+ * finished later, or aborted.
+ */
+int strFinishMigration(AVLStrMigration *mig) {
+    if (mig == NULL) return -1;  // Sanity check.
+    if (strMigrationStep(mig, ULONG_MAX) > 0) return -1;
+    deleteStrTree(mig->_from, 0);
+    free(mig);
+    return 0;
+}
+
+/* Moves all the entries already in the new tree back to the old one, which
+ * can then be used directly again, and frees the new tree along with the
+ * migration, as strFinishMigration does with the old one.
+ * Returns 0 if successful, -1 if the entries could not all be moved back: the
+ * migration then keeps going, but towards the old tree, and can be finished
+ * later, or aborted again.
+ */
+int strAbortMigration(AVLStrMigration *mig) {
+    if (mig == NULL) return -1;  // Sanity check.
+    AVLStrTree *to = mig->_to;
+    mig->_to = mig->_from;
+    mig->_from = to;
+    return strFinishMigration(mig);
+}
+
 // INTERNAL LIBRARY SUBROUTINES //
 /* Creates a new AVL node in the heap. Requires a pointer to a key string and
  * some data.
@@ -284,7 +879,9 @@ AVLStrNode *_createStrNode(char *newKey, void *newData) {
     newNode->_rightSon = NULL;
     newNode->_key = newKey;
     newNode->_data = newData;
+    newNode->_norm = 0;
     newNode->_height = 0;
+    newNode->_size = 1;
     return newNode;
 }
 
@@ -354,19 +951,213 @@ AVLStrNode *_strMaxKeySon(AVLStrNode *node) {
 /* Returns a pointer to the node with the specified key, or NULL. */
 AVLStrNode *_searchStrNode(AVLStrTree *tree, char *key) {
     if (tree->_root == NULL) return NULL;
-    AVLStrNode *curr = tree->_root;
+    AVLStrNode *curr;
+    AVLStrNode **slot = NULL;
+    // Look into the cache first, if there's one.
+    if (tree->_cache != NULL) {
+        slot = tree->_cache + _strCacheSlot(tree, key);
+        curr = __atomic_load_n(slot, __ATOMIC_RELAXED);
+        if ((curr != NULL) && (strcmp(curr->_key, key) == 0)) {
+            __atomic_add_fetch(&(tree->cacheHits), 1, __ATOMIC_RELAXED);
+            return curr;
+        }
+        __atomic_add_fetch(&(tree->cacheMisses), 1, __ATOMIC_RELAXED);
+    }
+    curr = tree->_root;
+    unsigned long long int norm = _strNormalize(tree, key);
+    unsigned long int lo = 0, hi = 0;
     int comp;
     while (curr != NULL) {
-        comp = strcmp(curr->_key, key);
+        comp = _strCompare(tree, curr, key, norm, &lo, &hi);
         if (comp > 0) {
             curr = curr->_leftSon;
         } else if (comp < 0) {
             curr = curr->_rightSon;
-        } else return curr;
+        } else {
+            if (slot != NULL) __atomic_store_n(slot, curr, __ATOMIC_RELAXED);
+            return curr;
+        }
     }
     return NULL;
 }
 
+/* Links a new node, with no father nor sons, into the tree, where its key
+ * belongs.
+ */
+void _strInsertNode(AVLStrTree *tree, AVLStrNode *newNode) {
+    newNode->_norm = _strNormalize(tree, newNode->_key);
+    if (tree->_root == NULL) {
+        // The tree is empty.
+        tree->_root = newNode;
+        tree->nodesCount++;
+        return;
+    }
+    // Look for the correct position and place it there.
+    AVLStrNode *curr = tree->_root;
+    AVLStrNode *pred = NULL;
+    unsigned long int lo = 0, hi = 0;
+    int comp = 0;
+    while (curr != NULL) {
+        pred = curr;
+        comp = _strCompare(tree, curr, newNode->_key, newNode->_norm, &lo, &hi);
+        if (comp >= 0) {
+            // Equals are kept in the left subtree.
+            curr = curr->_leftSon;
+        } else {
+            curr = curr->_rightSon;
+        }
+    }
+    // The last comparison was with the new node's father.
+    if (comp >= 0) {
+        _strInsertAsLeftSubtree(pred, newNode);
+    } else {
+        _strInsertAsRightSubtree(pred, newNode);
+    }
+    _strBalanceInsert(tree, newNode);
+    tree->nodesCount++;
+}
+
+/* Returns the normalized value of a key, or 0 if the tree has no normalizer. */
+unsigned long long int _strNormalize(AVLStrTree *tree, char *key) {
+    if (tree->_normalize == NULL) return 0;
+    return tree->_normalize(key, tree->_normCtx);
+}
+
+/* Compares the key of a node with a given one, which has the given normalized
+ * value, as the tree orders them, returning a value greater than, equal to or
+ * less than 0 like strcmp does.
+ * When keys are normalized by strKeyPrefix, matching values mean matching
+ * first 8 bytes: keys shorter than that are then equal, and the others are
+ * compared from the 9th byte on.
+ * If the tree skips shared prefixes, lo and hi hold the length of the prefix
+ * the key shares with the greatest key it follows and with the smallest it
+ * precedes, among those compared in the descent so far: the shortest of the
+ * two is skipped, and the one the node becomes is updated.
+ */
+int _strCompare(AVLStrTree *tree, AVLStrNode *node, char *key,
+                unsigned long long int norm, unsigned long int *lo,
+                unsigned long int *hi) {
+    if (tree->_normalize != NULL) {
+        if (node->_norm != norm) return node->_norm > norm ? 1 : -1;
+        if (tree->_normalize == strKeyPrefix) {
+            if ((norm & 0xFF) == 0) return 0;
+            return strcmp(node->_key + 8, key + 8);
+        }
+    } else if (tree->_skipPrefixes) {
+        unsigned long int shared = _strMismatch(node->_key, key,
+                                                (*lo < *hi) ? *lo : *hi);
+        int comp = (int) (unsigned char) node->_key[shared] -
+                   (int) (unsigned char) key[shared];
+        if (comp >= 0) {
+            *hi = shared;
+        } else *lo = shared;
+        return comp;
+    }
+    return strcmp(node->_key, key);
+}
+
+/* Returns the position of the first byte, from the given one on, at which two
+ * strings differ, or the first ends.
+ * Where SSE2 is available, 16 bytes of each are compared at a time, for as
+ * long as the blocks don't cross into another page: those may extend past the
+ * end of the strings, but never into memory that can't be read, and what they
+ * find after it is ignored. Only the bytes across page boundaries are compared
+ * one at a time. Reading past the end is intended, so it's hidden from the
+ * address sanitizer.
+ */
+__attribute__((no_sanitize_address))
+unsigned long int _strMismatch(const char *key1, const char *key2,
+                               unsigned long int from) {
+    const unsigned char *bytes1 = (const unsigned char *) key1;
+    const unsigned char *bytes2 = (const unsigned char *) key2;
+    unsigned long int i = from;
+    for (;;) {
+#ifdef __SSE2__
+        // Memory is mapped a whole page at a time, and byte i of both strings
+        // is readable (neither one has ended before it), so a block that
+        // starts there and stays in the same pages is readable too, even
+        // where it runs past the terminators: the bytes loaded from beyond
+        // them are never used, since the first stop comes no later than the
+        // terminator of either string. Pages are at least MIN_PAGE_SIZE bytes
+        // and aligned to it on every target this is built for.
+        if ((((uintptr_t) (bytes1 + i) % MIN_PAGE_SIZE) <=
+             MIN_PAGE_SIZE - 16) &&
+            (((uintptr_t) (bytes2 + i) % MIN_PAGE_SIZE) <=
+             MIN_PAGE_SIZE - 16)) {
+            __m128i block1 = _mm_loadu_si128((const __m128i *) (bytes1 + i));
+            __m128i block2 = _mm_loadu_si128((const __m128i *) (bytes2 + i));
+            // Bits are set for bytes that differ, or end the first string.
+            unsigned int stops =
+                    (~_mm_movemask_epi8(_mm_cmpeq_epi8(block1, block2)) &
+                     0xFFFF) |
+                    _mm_movemask_epi8(_mm_cmpeq_epi8(block1,
+                                                     _mm_setzero_si128()));
+            if (stops != 0) return i + __builtin_ctz(stops);
+            i += 16;
+            continue;
+        }
+#endif
+        if ((bytes1[i] != bytes2[i]) || (bytes1[i] == '\0')) return i;
+        i++;
+    }
+}
+
+/* Returns the cache slot of a given key, by FNV-1a and Fibonacci hashing. */
+unsigned long int _strCacheSlot(AVLStrTree *tree, char *key) {
+    unsigned long long int hash = strKeyHash(key, NULL);
+    return (unsigned long int) ((hash * 11400714819323198485ULL) >>
+                                (64 - tree->_cacheBits));
+}
+
+/* Removes a node that is being deleted from the cache. Since nodes keep their
+ * keys, it can only be in the slot of its own key.
+ */
+void _strCacheForget(AVLStrTree *tree, AVLStrNode *node) {
+    if (tree->_cache == NULL) return;
+    AVLStrNode **slot = tree->_cache + _strCacheSlot(tree, node->_key);
+    if (*slot == node) *slot = NULL;
+}
+
+/* Adds the given number of bytes to the memory used by the tree, charging them
+ * to its budget, if it has one. The charge is quiet, without the pressure
+ * callback, when the tree is in the middle of a visit or a modification that
+ * the callback must not disturb.
+ * The count is updated atomically, since concurrent visits charge it too.
+ * Returns 0 if successful, -1 if the budget refused them.
+ */
+int _strCharge(AVLStrTree *tree, unsigned long int bytes, int quiet) {
+    if (quiet) {
+        if (memBudgetTryCharge(tree->_budget, bytes) != 0) return -1;
+    } else if (memBudgetCharge(tree->_budget, bytes) != 0) return -1;
+    __atomic_add_fetch(&(tree->memUsed), bytes, __ATOMIC_RELAXED);
+    return 0;
+}
+
+/* Removes the given number of bytes from the memory used by the tree, giving
+ * them back to its budget, if it has one.
+ */
+void _strRelease(AVLStrTree *tree, unsigned long int bytes) {
+    memBudgetRelease(tree->_budget, bytes);
+    __atomic_sub_fetch(&(tree->memUsed), bytes, __ATOMIC_RELAXED);
+}
+
+/* Moves the charge for the given number of bytes from a tree to another one,
+ * charging the latter first, quietly since a node is being moved. Trees that
+ * share a budget just pass the bytes on, which it can't refuse.
+ * Returns 0 if successful, -1 if the budget of the latter refused them.
+ */
+int _strMoveCharge(AVLStrTree *from, AVLStrTree *to,
+                   unsigned long int bytes) {
+    if (from->_budget == to->_budget) {
+        __atomic_add_fetch(&(to->memUsed), bytes, __ATOMIC_RELAXED);
+        __atomic_sub_fetch(&(from->memUsed), bytes, __ATOMIC_RELAXED);
+        return 0;
+    }
+    if (_strCharge(to, bytes, 1) != 0) return -1;
+    _strRelease(from, bytes);
+    return 0;
+}
+
 /* Returns the height of a given node. */
 int _strHeight(AVLStrNode *node) {
     if (node == NULL) {
@@ -375,6 +1166,12 @@ int _strHeight(AVLStrNode *node) {
     return node->_height;
 }
 
+/* Returns the number of nodes in the subtree rooted in a given node. */
+unsigned long int _strSize(AVLStrNode *node) {
+    if (node == NULL) return 0;
+    return node->_size;
+}
+
 /* Sets the height of the specified node to the given value. */
 void _strSetHeight(AVLStrNode *node, int newHeight) {
     if (node != NULL) node->_height = newHeight;
@@ -386,138 +1183,142 @@ int _strBalanceFactor(AVLStrNode *node) {
     return _strHeight(node->_leftSon) - _strHeight(node->_rightSon);
 }
 
-/* Updates the height of a given node. */
+/* Updates the height and the subtree size of a given node. */
 void _strUpdateHeight(AVLStrNode *node) {
     if (node != NULL) {
         _strSetHeight(node, MAX(_strHeight(node->_leftSon),
                                 _strHeight(node->_rightSon)) + 1);
+        node->_size = _strSize(node->_leftSon) + _strSize(node->_rightSon) + 1;
     }
 }
 
-/* Swaps contents between two nodes. */
-void _strSwapInfo(AVLStrNode *node1, AVLStrNode *node2) {
-    char *key1 = node1->_key;
-    void *data1 = node1->_data;
-    char *key2 = node2->_key;
-    void *data2 = node2->_data;
-    node1->_key = key2;
-    node2->_key = key1;
-    node1->_data = data2;
-    node2->_data = data1;
+/* Puts the subtree rooted in a given node in the place of another node, which
+ * is left detached from its father.
+ */
+void _strReplaceSubtree(AVLStrTree *tree, AVLStrNode *node,
+                        AVLStrNode *newNode) {
+    AVLStrNode *father = node->_father;
+    node->_father = NULL;
+    if (father == NULL) {
+        if (newNode != NULL) newNode->_father = NULL;
+        tree->_root = newNode;
+    } else if (father->_leftSon == node) {
+        _strInsertAsLeftSubtree(father, newNode);
+    } else _strInsertAsRightSubtree(father, newNode);
 }
 
-/* Performs a simple right rotation at the specified node. */
-void _strRightRotation(AVLStrNode *node) {
+/* Performs a simple right rotation at the specified node.
+ * Nodes are relinked rather than having their contents swapped, so that
+ * pointers to them stay valid.
+ */
+void _strRightRotation(AVLStrTree *tree, AVLStrNode *node) {
     AVLStrNode *leftSon = node->_leftSon;
-    // Swap the node and its son's contents to make it climb.
-    _strSwapInfo(node, leftSon);
-    // Shrink the tree portion in subtrees.
-    AVLStrNode *rTree = _strCutRightSubtree(node);
-    AVLStrNode *lTree = _strCutLeftSubtree(node);
-    AVLStrNode *lTree_l = _strCutLeftSubtree(leftSon);
-    AVLStrNode *lTree_r = _strCutRightSubtree(leftSon);
+    // Make the son climb in place of the node.
+    _strReplaceSubtree(tree, node, leftSon);
     // Recombine portions to respect the search property.
-    _strInsertAsRightSubtree(lTree, rTree);
-    _strInsertAsLeftSubtree(lTree, lTree_r);
-    _strInsertAsRightSubtree(node, lTree);
-    _strInsertAsLeftSubtree(node, lTree_l);
+    _strInsertAsLeftSubtree(node, _strCutRightSubtree(leftSon));
+    _strInsertAsRightSubtree(leftSon, node);
     // Update the height of the involved nodes.
-    _strUpdateHeight(node->_rightSon);
     _strUpdateHeight(node);
+    _strUpdateHeight(leftSon);
 }
 
-/* Performs a simple left rotation at the specified node. */
-void _strLeftRotation(AVLStrNode *node) {
+/* Performs a simple left rotation at the specified node.
+ * Nodes are relinked rather than having their contents swapped, so that
+ * pointers to them stay valid.
+ */
+void _strLeftRotation(AVLStrTree *tree, AVLStrNode *node) {
     AVLStrNode *rightSon = node->_rightSon;
-    // Swap the node and its son's contents to make it climb.
-    _strSwapInfo(node, rightSon);
-    // Shrink the tree portion in subtrees.
-    AVLStrNode *rTree = _strCutRightSubtree(node);
-    AVLStrNode *lTree = _strCutLeftSubtree(node);
-    AVLStrNode *rTree_l = _strCutLeftSubtree(rightSon);
-    AVLStrNode *rTree_r = _strCutRightSubtree(rightSon);
+    // Make the son climb in place of the node.
+    _strReplaceSubtree(tree, node, rightSon);
     // Recombine portions to respect the search property.
-    _strInsertAsLeftSubtree(rTree, lTree);
-    _strInsertAsRightSubtree(rTree, rTree_l);
-    _strInsertAsLeftSubtree(node, rTree);
-    _strInsertAsRightSubtree(node, rTree_r);
+    _strInsertAsRightSubtree(node, _strCutLeftSubtree(rightSon));
+    _strInsertAsLeftSubtree(rightSon, node);
     // Update the height of the involved nodes.
-    _strUpdateHeight(node->_leftSon);
     _strUpdateHeight(node);
+    _strUpdateHeight(rightSon);
 }
 
-/* Examines the balance factor of a given node and eventually rotates. */
-void _strRotate(AVLStrNode *node) {
+/* Examines the balance factor of a given node and eventually rotates.
+ * Returns the node that is now at the top of the subtree.
+ */
+AVLStrNode *_strRotate(AVLStrTree *tree, AVLStrNode *node) {
     int balFactor = _strBalanceFactor(node);
     if (balFactor == 2) {
         if (_strBalanceFactor(node->_leftSon) >= 0) {
             // LL displacement: rotate right.
-            _strRightRotation(node);
+            _strRightRotation(tree, node);
         } else {
             // LR displacement: apply double rotation.
-            _strLeftRotation(node->_leftSon);
-            _strRightRotation(node);
+            _strLeftRotation(tree, node->_leftSon);
+            _strRightRotation(tree, node);
         }
     } else if (balFactor == -2) {
         if (_strBalanceFactor(node->_rightSon) <= 0) {
             // RR displacement: rotate left.
-            _strLeftRotation(node);
+            _strLeftRotation(tree, node);
         } else {
             // RL displacement: apply double rotation.
-            _strRightRotation(node->_rightSon);
-            _strLeftRotation(node);
+            _strRightRotation(tree, node->_rightSon);
+            _strLeftRotation(tree, node);
         }
-    }
+    } else return node;
+    return node->_father;
 }
 
 /* Updates heights and looks for displacements following an insertion. */
-void _strBalanceInsert(AVLStrNode *newNode) {
+void _strBalanceInsert(AVLStrTree *tree, AVLStrNode *newNode) {
     AVLStrNode *curr = newNode->_father;
     while (curr != NULL) {
         if (abs(_strBalanceFactor(curr)) >= 2) {
-            // Unbalanced node found.
-            break;
-        } else {
-            _strUpdateHeight(curr);
-            curr = curr->_father;
-        }
+            // Unbalanced node found: the rotation restores the height the
+            // subtree had before the insertion, but the sizes of the nodes
+            // above still have to be updated.
+            curr = _strRotate(tree, curr);
+        } else _strUpdateHeight(curr);
+        curr = curr->_father;
     }
-    if (curr != NULL) _strRotate(curr);
 }
 
 /* Updates heights and looks for displacements following a deletion. */
-void _strBalanceDelete(AVLStrNode *remFather) {
+void _strBalanceDelete(AVLStrTree *tree, AVLStrNode *remFather) {
     AVLStrNode *curr = remFather;
     while (curr != NULL) {
         if (abs(_strBalanceFactor(curr)) >= 2) {
             // There may be more than one unbalanced node.
-            _strRotate(curr);
+            curr = _strRotate(tree, curr);
         } else _strUpdateHeight(curr);
         curr = curr->_father;
     }
 }
 
-/* Cuts a node with a single son. */
-AVLStrNode *_strCutOneSonNode(AVLStrNode *node) {
-    AVLStrNode *son = NULL;
-    AVLStrNode *father = node->_father;
-    if (node->_leftSon != NULL) {
-        son = node->_leftSon;
-    } else if (node->_rightSon != NULL) {
-        son = node->_rightSon;
-    }
-    if (son == NULL) {  // The node is a leaf.
-        son = _strCutSubtree(node);  // Will be returned later.
+/* Removes a node from the tree and rebalances it. If the node has two sons,
+ * its predecessor takes its place. The node keeps its contents and is left
+ * totally disconnected, ready to be freed.
+ */
+void _strDeleteNode(AVLStrTree *tree, AVLStrNode *node) {
+    AVLStrNode *remFather;  // Lowest node that lost a descendant.
+    if ((node->_leftSon == NULL) || (node->_rightSon == NULL)) {
+        // Let the only son, if any, take the place of the node.
+        remFather = node->_father;
+        _strReplaceSubtree(tree, node, (node->_leftSon != NULL) ?
+                                       _strCutLeftSubtree(node) :
+                                       _strCutRightSubtree(node));
     } else {
-        // Swap the content from the son to the father.
-        _strSwapInfo(node, son);
-        // Cut the node and balance the deletion.
-        _strCutSubtree(son);
-        _strInsertAsRightSubtree(node, _strCutSubtree(son->_rightSon));
-        _strInsertAsLeftSubtree(node, _strCutSubtree(son->_leftSon));
+        // Detach the predecessor, then let it take the place of the node.
+        AVLStrNode *maxLeft = _strMaxKeySon(node->_leftSon);
+        remFather = maxLeft->_father;
+        if (remFather == node) {
+            remFather = maxLeft;
+            _strCutLeftSubtree(node);
+        } else {
+            _strReplaceSubtree(tree, maxLeft, _strCutLeftSubtree(maxLeft));
+            _strInsertAsLeftSubtree(maxLeft, _strCutLeftSubtree(node));
+        }
+        _strInsertAsRightSubtree(maxLeft, _strCutRightSubtree(node));
+        _strReplaceSubtree(tree, node, maxLeft);
     }
-    _strBalanceDelete(father);
-    return son;  // Return the node to free, now totally disconnected.
+    _strBalanceDelete(tree, remFather);
 }
 
 /* Performs an in-order, recursive DFS. */
@@ -590,3 +1391,320 @@ void _strPostODFS(AVLStrNode *rootNode, void ***intPtr, int intOpt) {
         **(intPtr) = rootNode->_data;
     }
 }
+
+/* Allocates the result array of a visit, of the size required by the given
+ * options, and tells which one of them is going to be used.
+ */
+void *_strAllocVisit(unsigned long int count, int opts, int *intOpt) {
+    if (opts & SEARCH_DATA) {
+        *intOpt = SEARCH_DATA;
+        return calloc(count, sizeof(void *));
+    } else if (opts & SEARCH_KEYS) {
+        *intOpt = SEARCH_KEYS;
+        return calloc(count, sizeof(char *));
+    } else if (opts & SEARCH_NODES) {
+        *intOpt = SEARCH_NODES;
+        return calloc(count, sizeof(AVLStrNode *));
+    }
+    return NULL;  // Invalid option.
+}
+
+/* Stores what the option requires of a node at a given position of the result
+ * array of a visit.
+ */
+void _strStoreEntry(void *res, unsigned long int pos, AVLStrNode *node,
+                    int intOpt) {
+    if (intOpt & SEARCH_NODES) {
+        ((void **) res)[pos] = node;
+    } else if (intOpt & SEARCH_KEYS) {
+        ((char **) res)[pos] = node->_key;
+    } else if (intOpt & SEARCH_DATA) {
+        ((void **) res)[pos] = node->_data;
+    }
+}
+
+/* Returns the depth at which a tree of the given height has to be cut to get
+ * enough subtrees for the given number of threads.
+ */
+int _strCutDepth(int height, int nthreads) {
+    int cutDepth = 0;
+    while (((1UL << cutDepth) <
+            (unsigned long int) nthreads * PAR_TASKS_PER_THREAD) &&
+           (cutDepth < height)) cutDepth++;
+    return cutDepth;
+}
+
+/* Performs a recursive DFS of a subtree, storing the entries starting from
+ * the given offset of the result array.
+ */
+void _strDFSAt(AVLStrParVisit *visit, AVLStrNode *node,
+               unsigned long int offset) {
+    if (node == NULL) return;
+    unsigned long int leftSize = _strSize(node->_leftSon);
+    unsigned long int rightSize = _strSize(node->_rightSon);
+    if (visit->_type & DFS_PRE_ORDER) {
+        _strStoreEntry(visit->_res, offset, node, visit->_intOpt);
+        _strDFSAt(visit, node->_leftSon, offset + 1);
+        _strDFSAt(visit, node->_rightSon, offset + 1 + leftSize);
+    } else if (visit->_type & DFS_IN_ORDER) {
+        _strDFSAt(visit, node->_leftSon, offset);
+        _strStoreEntry(visit->_res, offset + leftSize, node, visit->_intOpt);
+        _strDFSAt(visit, node->_rightSon, offset + leftSize + 1);
+    } else {
+        _strDFSAt(visit, node->_leftSon, offset);
+        _strDFSAt(visit, node->_rightSon, offset + leftSize);
+        _strStoreEntry(visit->_res, offset + leftSize + rightSize, node,
+                       visit->_intOpt);
+    }
+}
+
+/* Performs a step of a parallel DFS: stores the root of the subtree, then
+ * visits its sons, the left one in a new task. Subtrees not bigger than the
+ * grain are visited sequentially.
+ */
+void _strParDFS(void *arg) {
+    AVLStrParStep *step = (AVLStrParStep *) arg;
+    AVLStrParVisit *visit = step->_visit;
+    AVLStrNode *node = step->_node;
+    if ((node == NULL) || (node->_size <= visit->_grain)) {
+        _strDFSAt(visit, node, step->_offset);
+        return;
+    }
+    unsigned long int leftSize = _strSize(node->_leftSon);
+    unsigned long int rightSize = _strSize(node->_rightSon);
+    AVLStrParStep left = {visit, node->_leftSon, step->_offset};
+    AVLStrParStep right = {visit, node->_rightSon, step->_offset + leftSize};
+    if (visit->_type & DFS_PRE_ORDER) {
+        _strStoreEntry(visit->_res, step->_offset, node, visit->_intOpt);
+        left._offset++;
+        right._offset++;
+    } else if (visit->_type & DFS_IN_ORDER) {
+        _strStoreEntry(visit->_res, step->_offset + leftSize, node,
+                       visit->_intOpt);
+        right._offset++;
+    } else {
+        _strStoreEntry(visit->_res, step->_offset + leftSize + rightSize, node,
+                       visit->_intOpt);
+    }
+    AVLWorkTask task;
+    workPoolSpawn(&task, _strParDFS, &left);
+    _strParDFS(&right);
+    workPoolSync(&task);
+}
+
+/* Performs a recursive DFS of a subtree meeting the nodes of each level in the
+ * order required by a BFS, and either counts them or stores them at the
+ * cursor of their level in the given row of the offsets matrix.
+ * Row zero is the top of the tree, so its visit stops at the cut depth.
+ */
+void _strLevelVisit(AVLStrParVisit *visit, AVLStrNode *node, int depth,
+                    unsigned long int row) {
+    if (node == NULL) return;
+    if ((row == 0) && (depth == visit->_cutDepth)) return;
+    unsigned long int *cell = visit->_offsets + row * visit->_levels + depth;
+    if (visit->_store)
+        _strStoreEntry(visit->_res, *cell, node, visit->_intOpt);
+    (*cell)++;
+    if (visit->_type & BFS_LEFT_FIRST) {
+        _strLevelVisit(visit, node->_leftSon, depth + 1, row);
+        _strLevelVisit(visit, node->_rightSon, depth + 1, row);
+    } else {
+        _strLevelVisit(visit, node->_rightSon, depth + 1, row);
+        _strLevelVisit(visit, node->_leftSon, depth + 1, row);
+    }
+}
+
+/* Collects the subtrees rooted at the cut depth, in the order in which a BFS
+ * would meet them.
+ */
+void _strParBFSSplit(AVLStrParVisit *visit, AVLStrNode *node, int depth) {
+    if (node == NULL) return;
+    if (depth == visit->_cutDepth) {
+        visit->_roots[visit->_nTasks] = node;
+        visit->_nTasks++;
+        return;
+    }
+    if (visit->_type & BFS_LEFT_FIRST) {
+        _strParBFSSplit(visit, node->_leftSon, depth + 1);
+        _strParBFSSplit(visit, node->_rightSon, depth + 1);
+    } else {
+        _strParBFSSplit(visit, node->_rightSon, depth + 1);
+        _strParBFSSplit(visit, node->_leftSon, depth + 1);
+    }
+}
+
+/* Visits one of the subtrees of a parallel BFS. */
+void _strParBFSTask(void *arg, unsigned long int task) {
+    AVLStrParVisit *visit = (AVLStrParVisit *) arg;
+    _strLevelVisit(visit, visit->_roots[task], visit->_cutDepth, task + 1);
+}
+
+/* Compares two entries to sort by their keys, for qsort. */
+int _strComparePairs(const void *pair1, const void *pair2) {
+    return strcmp(((const AVLStrPair *) pair1)->_key,
+                  ((const AVLStrPair *) pair2)->_key);
+}
+
+/* Copies a chunk of the input of a parallel build in the entries to sort, and
+ * sorts it.
+ */
+void _strParSortTask(void *arg, unsigned long int chunk) {
+    AVLStrParBuild *build = (AVLStrParBuild *) arg;
+    unsigned long int lo = build->_bounds[chunk];
+    unsigned long int hi = build->_bounds[chunk + 1];
+    for (unsigned long int i = lo; i < hi; i++) {
+        build->_pairs[i]._key = build->_keys[i];
+        build->_pairs[i]._data = (build->_data != NULL) ? build->_data[i] :
+                                 NULL;
+    }
+    qsort(build->_pairs + lo, hi - lo, sizeof(AVLStrPair), _strComparePairs);
+}
+
+/* Returns how many entries of the first run come before the given rank in
+ * the merge of two sorted runs. On equal keys, the first run goes first.
+ */
+unsigned long int _strCoRank(AVLStrPair *run1, unsigned long int len1,
+                             AVLStrPair *run2, unsigned long int len2,
+                             unsigned long int rank) {
+    unsigned long int lo = (rank > len2) ? rank - len2 : 0;
+    unsigned long int hi = (rank < len1) ? rank : len1;
+    unsigned long int mid;
+    while (lo < hi) {
+        mid = lo + (hi - lo) / 2;
+        if (strcmp(run2[rank - mid - 1]._key, run1[mid]._key) >= 0) {
+            lo = mid + 1;
+        } else hi = mid;
+    }
+    return lo;
+}
+
+/* Merges a part of two adjacent sorted runs. If the first run is the last
+ * one, it is just copied.
+ */
+void _strParMergeTask(void *arg, unsigned long int task) {
+    AVLStrParBuild *build = (AVLStrParBuild *) arg;
+    unsigned long int run = 2 * (task / build->_parts);
+    unsigned long int part = task % build->_parts;
+    unsigned long int lo = build->_bounds[run];
+    unsigned long int mid = build->_bounds[run + 1];
+    unsigned long int hi = (run + 2 <= build->_nRuns) ?
+                           build->_bounds[run + 2] : mid;
+    AVLStrPair *run1 = build->_pairs + lo;
+    AVLStrPair *run2 = build->_pairs + mid;
+    unsigned long int len1 = mid - lo, len2 = hi - mid;
+    // Find the ranks of the merged output this part is in charge of, and
+    // where they come from in the two runs.
+    unsigned long int first = (len1 + len2) * part / build->_parts;
+    unsigned long int last = (len1 + len2) * (part + 1) / build->_parts;
+    unsigned long int i = _strCoRank(run1, len1, run2, len2, first);
+    unsigned long int j = first - i;
+    unsigned long int iEnd = _strCoRank(run1, len1, run2, len2, last);
+    unsigned long int jEnd = last - iEnd;
+    AVLStrPair *out = build->_tmp + lo + first;
+    while ((i < iEnd) && (j < jEnd)) {
+        if (strcmp(run1[i]._key, run2[j]._key) <= 0) {
+            *(out++) = run1[i++];
+        } else *(out++) = run2[j++];
+    }
+    while (i < iEnd) *(out++) = run1[i++];
+    while (j < jEnd) *(out++) = run2[j++];
+}
+
+/* Returns the height of a perfectly balanced tree with the given number of
+ * nodes.
+ */
+int _strBuildHeight(unsigned long int count) {
+    int height = -1;
+    while (count > 0) {
+        count >>= 1;
+        height++;
+    }
+    return height;
+}
+
+/* Performs a step of a parallel build: builds a perfectly balanced subtree
+ * from a range of the sorted entries, taking the middle one as root, and
+ * attaches it in the given place. The left son is built by a new task, unless
+ * the subtree is not bigger than the grain.
+ */
+void _strParBuild(void *arg) {
+    AVLStrBuildStep *step = (AVLStrBuildStep *) arg;
+    AVLStrParBuild *build = step->_build;
+    *(step->_slot) = NULL;
+    if (step->_lo >= step->_hi) return;
+    unsigned long int mid = step->_lo + (step->_hi - step->_lo) / 2;
+    AVLStrNode *newNode = _createStrNode(build->_pairs[mid]._key,
+                                         build->_pairs[mid]._data);
+    if (newNode == NULL) {
+        __atomic_store_n(&(build->_failed), 1, __ATOMIC_RELAXED);
+        return;
+    }
+    newNode->_father = step->_father;
+    newNode->_height = _strBuildHeight(step->_hi - step->_lo);
+    newNode->_size = step->_hi - step->_lo;
+    *(step->_slot) = newNode;
+    AVLStrBuildStep left = {build, newNode, &(newNode->_leftSon), step->_lo,
+                            mid};
+    AVLStrBuildStep right = {build, newNode, &(newNode->_rightSon), mid + 1,
+                             step->_hi};
+    if (newNode->_size > build->_grain) {
+        AVLWorkTask task;
+        workPoolSpawn(&task, _strParBuild, &left);
+        _strParBuild(&right);
+        workPoolSync(&task);
+    } else {
+        _strParBuild(&left);
+        _strParBuild(&right);
+    }
+}
+
+/* Frees all the nodes of a subtree, recursively. */
+void _strFreeSubtree(AVLStrNode *node) {
+    if (node == NULL) return;
+    _strFreeSubtree(node->_leftSon);
+    _strFreeSubtree(node->_rightSon);
+    _deleteStrNode(node);
+}
+
+/* Folds a subtree recursively following the order of the keys, either
+ * calling the function on each entry or reducing them, starting from the given
+ * accumulated value. Returns the new accumulated value.
+ */
+void *_strFold(AVLStrParFold *fold, AVLStrNode *node, void *acc) {
+    while (node != NULL) {
+        acc = _strFold(fold, node->_leftSon, acc);
+        if (fold->_forEach != NULL) {
+            fold->_forEach(node->_key, node->_data, fold->_ctx);
+        } else acc = fold->_reduce(acc, node->_key, node->_data, fold->_ctx);
+        node = node->_rightSon;
+    }
+    return acc;
+}
+
+/* Performs a step of a parallel fold: folds the sons of a subtree, the left
+ * one in a new task, then adds the root to the result of the left son and
+ * combines it with the result of the right one. Subtrees not bigger than the
+ * grain are folded sequentially.
+ */
+void _strParFold(void *arg) {
+    AVLStrFoldStep *step = (AVLStrFoldStep *) arg;
+    AVLStrParFold *fold = step->_fold;
+    AVLStrNode *node = step->_node;
+    if ((node == NULL) || (node->_size <= fold->_grain)) {
+        step->_acc = _strFold(fold, node, fold->_identity);
+        return;
+    }
+    AVLStrFoldStep left = {fold, node->_leftSon, fold->_identity};
+    AVLStrFoldStep right = {fold, node->_rightSon, fold->_identity};
+    AVLWorkTask task;
+    workPoolSpawn(&task, _strParFold, &left);
+    _strParFold(&right);
+    workPoolSync(&task);
+    if (fold->_forEach != NULL) {
+        fold->_forEach(node->_key, node->_data, fold->_ctx);
+    } else {
+        step->_acc = fold->_combine(fold->_reduce(left._acc, node->_key,
+                                                  node->_data, fold->_ctx),
+                                    right._acc, fold->_ctx);
+    }
+}
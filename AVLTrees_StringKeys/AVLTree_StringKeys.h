@@ -1,6 +1,6 @@
 /* Roberto Masocco
  * Creation Date: 6/8/2018
- * Latest Version: 26/7/2019
+ * Latest Version: 17/10/2026
  * ----------------------------------------------------------------------------
  * This file contains type definitions and declarations for the AVL Tree data
  * structure. See the source file for brief descriptions of what each function
@@ -17,6 +17,9 @@
 #ifndef AVLTREES_STRINGKEYS_H
 #define AVLTREES_STRINGKEYS_H
 
+#include "../AVLTrees_Common/AVLTree_WorkPool.h"
+#include "../AVLTrees_Common/AVLTree_MemBudget.h"
+
 /* These options can be OR'd in a call to the delete functions to specify
  * if also the keys and/or the data in the nodes must be freed in the heap.
  * If nothing is specified, only the nodes are freed.
@@ -45,10 +48,19 @@
 #define BFS_LEFT_FIRST 0x100
 #define BFS_RIGHT_FIRST 0x200
 
+/* The cache of the nodes found by searches (see strSetCache) can have at most
+ * 2^CACHE_MAX_BITS slots: bigger sizes are cut down to that.
+ */
+#define CACHE_MAX_BITS 30
+
 /* An AVL Tree's node stores pointers to its "father" node and to its sons.
  * To calculate the balance factor, the height of the node is also stored.
+ * The number of nodes in the subtree rooted in each node is kept too, so that
+ * the position of every entry in a visit can be computed without visiting the
+ * ones that come before it.
  * In this implementation, ASCII strings are used as keys in the dictionary,
- * but there are no buffers for those so pointers must be provided.
+ * but there are no buffers for those so pointers must be provided. If the
+ * tree normalizes its keys, the normalized value of the key is stored too.
  * The data kept inside the node can be everything, as long as it's at most
  * 64-bits wide. These can be pointers, too.
  * Note that, as per the deletion options, is not possible to have only SOME
@@ -59,7 +71,9 @@ typedef struct _avlStrNode {
     struct _avlStrNode *_father;
     struct _avlStrNode *_leftSon;
     struct _avlStrNode *_rightSon;
+    unsigned long int _size;
     int _height;
+    unsigned long long int _norm;
     char *_key;
     void *_data;
 } AVLStrNode;
@@ -70,13 +84,47 @@ typedef struct _avlStrNode {
  * AVL trees implemented like this have a size limit set by the maximum
  * amount representable with an unsigned long integer, automatically set (as
  * long as you compile this code on the same machine you're going to use it on).
+ * A cache of recently found nodes can also be kept, in which case the number
+ * of searches it answered, or not, is counted.
+ * Keys can be normalized into 64-bit integers by a function (called with the
+ * given context) when they are inserted and searched: entries are then ordered
+ * by their normalized keys first, which are compared as integers, and then
+ * by the keys themselves. Otherwise, descents can skip the bytes that keys
+ * are known to share with the one looked for.
+ * The number of bytes the tree is using, for itself, its nodes, their keys
+ * (which it may free) and its cache, and those that operations are using
+ * while they run, is kept up to date, and can be charged to a memory budget
+ * (see AVLTrees_Common). Memory used by the data, and the arrays returned to
+ * the caller, are not counted.
  */
 typedef struct {
     AVLStrNode *_root;
     unsigned long int nodesCount;
     unsigned long int maxNodes;
+    AVLStrNode **_cache;
+    int _cacheBits;
+    unsigned long int cacheHits;
+    unsigned long int cacheMisses;
+    unsigned long long int (*_normalize)(const char *key, void *ctx);
+    void *_normCtx;
+    int _skipPrefixes;
+    unsigned long int memUsed;
+    AVLMemBudget *_budget;
 } AVLStrTree;
 
+/* A migration moves the entries of a tree into another one, which may have
+ * different settings (e.g. a normalizer, which can only be given to an empty
+ * tree), a few at a time, while both are used through it. Each operation on
+ * it first moves up to a given number of entries, then works on the tree each
+ * entry is in, since none is ever in both: new entries go to the new tree.
+ * Neither tree must be used directly until the migration is finished.
+ */
+typedef struct {
+    AVLStrTree *_from;
+    AVLStrTree *_to;
+    unsigned long int _step;
+} AVLStrMigration;
+
 /* Library functions. */
 AVLStrTree *createStrTree(void);
 int deleteStrTree(AVLStrTree *tree, int opts);
@@ -85,5 +133,38 @@ unsigned long int strInsert(AVLStrTree *tree, char *newKey, void *newData);
 int strDelete(AVLStrTree *tree, char *key, int opts);
 void **strDFS(AVLStrTree *tree, int type, int opts);
 void **strBFS(AVLStrTree *tree, int type, int opts);
+int strSetBudget(AVLStrTree *tree, AVLMemBudget *budget);
+int strSetCache(AVLStrTree *tree, unsigned long int size);
+int strSetNormalizer(AVLStrTree *tree,
+                     unsigned long long int (*normalize)(const char *key,
+                                                         void *ctx),
+                     void *ctx);
+unsigned long long int strKeyPrefix(const char *key, void *ctx);
+unsigned long long int strKeyHash(const char *key, void *ctx);
+int strSetPrefixSkip(AVLStrTree *tree, int enable);
+void **strParallelDFS(AVLStrTree *tree, int type, int opts,
+                      AVLWorkPool *pool);
+void **strParallelBFS(AVLStrTree *tree, int type, int opts,
+                      AVLWorkPool *pool);
+AVLStrMigration *strStartMigration(AVLStrTree *from, AVLStrTree *to,
+                                   unsigned long int step);
+void *strMigrationSearch(AVLStrMigration *mig, char *key, int opts);
+unsigned long int strMigrationInsert(AVLStrMigration *mig, char *newKey,
+                                     void *newData);
+int strMigrationDelete(AVLStrMigration *mig, char *key, int opts);
+unsigned long int strMigrationStep(AVLStrMigration *mig,
+                                   unsigned long int count);
+int strFinishMigration(AVLStrMigration *mig);
+int strAbortMigration(AVLStrMigration *mig);
+AVLStrTree *strBuildParallel(char **keys, void **data, unsigned long int n,
+                             AVLWorkPool *pool);
+int strParallelForEach(AVLStrTree *tree,
+                       void (*fn)(char *key, void *data, void *ctx),
+                       void *ctx, AVLWorkPool *pool);
+void *strParallelReduce(AVLStrTree *tree,
+                        void *(*reduce)(void *acc, char *key, void *data,
+                                        void *ctx),
+                        void *(*combine)(void *acc1, void *acc2, void *ctx),
+                        void *identity, void *ctx, AVLWorkPool *pool);
 
 #endif
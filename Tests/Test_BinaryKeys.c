@@ -0,0 +1,154 @@
+/* AVL Trees library contributors
+ * Creation Date: 17/10/2026
+ * Latest Version: 17/10/2026
+ * ----------------------------------------------------------------------------
+ * This is a self-checking test program for the binary keys flavour. Random
+ * sequences of insertions and deletions of keys that hold zeros, and that are
+ * prefixes of each other, are run against a reference count of the keys, and
+ * after each batch the whole structure of the tree is checked: ordering,
+ * heights and balance, subtree sizes and father links.
+ * Build and run it from this directory with:
+ *   gcc -std=gnu11 -O2 -I../AVLTrees_BinaryKeys Test_BinaryKeys.c
+ *       ../AVLTrees_BinaryKeys/AVLTree_BinaryKeys.c
+ *       -o Test_BinaryKeys && ./Test_BinaryKeys
+ * It prints every failed check, and exits with 1 if there were any.
+ */
+/* This code is released under the MIT license.
+ * See the attached LICENSE file.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "AVLTree_BinaryKeys.h"
+
+/* Macro to record a failed check, telling where it is. */
+#define CHECK(COND) do {                                                    \
+    if (!(COND)) {                                                          \
+        fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__,   \
+                #COND);                                                     \
+        failures++;                                                         \
+    }                                                                       \
+} while (0)
+
+/* Macro to turn the number of a key into the data it's stored with, so that
+ * every entry found can be checked against its key.
+ */
+#define KEY_DATA(NUM) ((void *) (long int) (2 * (long int) (NUM) + 1))
+
+/* Number of different keys used by the workload, and their greatest length. */
+#define KEY_RANGE 2000
+#define KEY_MAX_LEN 12
+
+/* Test subroutines declarations. */
+int compareKeys(const AVLBinKey *key1, const AVLBinKey *key2);
+unsigned long int checkBinSubtree(AVLBinNode *node, AVLBinNode *father,
+                                  AVLBinNode **min, AVLBinNode **max);
+void checkBinTree(AVLBinTree *tree);
+
+/* Number of failed checks. */
+int failures = 0;
+
+int main(void) {
+    static unsigned char bytes[KEY_RANGE][KEY_MAX_LEN];
+    static unsigned long int lens[KEY_RANGE], counts[KEY_RANGE];
+    static int same[KEY_RANGE];
+    unsigned short rng[3] = {0x1234, 0x5678, 0x9ABC};
+    // Few different bytes make many keys share prefixes, or be prefixes.
+    for (int i = 0; i < KEY_RANGE; i++) {
+        lens[i] = (unsigned long int) (nrand48(rng) % (KEY_MAX_LEN + 1));
+        for (unsigned long int j = 0; j < lens[i]; j++)
+            bytes[i][j] = (unsigned char) (nrand48(rng) % 3) * 0x7F;
+        // Keys with the same bytes are counted as the first one of them.
+        same[i] = i;
+        for (int j = 0; j < i; j++) {
+            if ((lens[j] == lens[i]) &&
+                (memcmp(bytes[j], bytes[i], lens[i]) == 0)) {
+                same[i] = j;
+                break;
+            }
+        }
+    }
+    AVLBinTree *tree = createBinTree();
+    for (int round = 0; round < 40; round++) {
+        for (int i = 0; i < 1000; i++) {
+            long int num = same[nrand48(rng) % KEY_RANGE];
+            long int op = nrand48(rng) % 10;
+            if (op < 4) {
+                CHECK(binInsert(tree, bytes[num], lens[num],
+                                KEY_DATA(num)) > 0);
+                counts[num]++;
+            } else if (op < 7) {
+                CHECK(binDelete(tree, bytes[num], lens[num], 0) ==
+                      (counts[num] > 0));
+                if (counts[num] > 0) counts[num]--;
+            } else {
+                // Keys are looked for through copies, not the same pointers.
+                unsigned char copy[KEY_MAX_LEN];
+                memcpy(copy, bytes[num], lens[num]);
+                void *found = binSearch(tree, copy, lens[num], SEARCH_DATA);
+                CHECK((found != NULL) == (counts[num] > 0));
+                if (found != NULL) CHECK(found == KEY_DATA(num));
+            }
+        }
+        checkBinTree(tree);
+    }
+    deleteBinTree(tree, 0);
+    if (failures > 0) {
+        printf("%d checks failed\n", failures);
+        return 1;
+    }
+    printf("All checks passed\n");
+    return 0;
+}
+
+// TEST SUBROUTINES //
+/* Checks the structure of the whole tree. */
+void checkBinTree(AVLBinTree *tree) {
+    AVLBinNode *min, *max;
+    unsigned long int size = 0;
+    if (tree->_root != NULL)
+        size = checkBinSubtree(tree->_root, NULL, &min, &max);
+    CHECK(size == tree->nodesCount);
+}
+
+/* Checks the subtree rooted in a node: father links, ordering, heights,
+ * balance and sizes. The nodes with its smallest and greatest keys are stored
+ * where min and max point.
+ * Returns the number of nodes in the subtree.
+ */
+unsigned long int checkBinSubtree(AVLBinNode *node, AVLBinNode *father,
+                                  AVLBinNode **min, AVLBinNode **max) {
+    AVLBinNode *leftMin, *leftMax, *rightMin, *rightMax;
+    unsigned long int leftSize = 0, rightSize = 0;
+    int leftHeight = -1, rightHeight = -1;
+    CHECK(node->_father == father);
+    *min = node;
+    *max = node;
+    if (node->_leftSon != NULL) {
+        leftSize = checkBinSubtree(node->_leftSon, node, &leftMin, &leftMax);
+        CHECK(compareKeys(&(leftMax->_key), &(node->_key)) <= 0);
+        leftHeight = node->_leftSon->_height;
+        *min = leftMin;
+    }
+    if (node->_rightSon != NULL) {
+        rightSize = checkBinSubtree(node->_rightSon, node, &rightMin,
+                                    &rightMax);
+        CHECK(compareKeys(&(rightMin->_key), &(node->_key)) >= 0);
+        rightHeight = node->_rightSon->_height;
+        *max = rightMax;
+    }
+    CHECK(node->_height == 1 + (leftHeight > rightHeight ? leftHeight :
+                                rightHeight));
+    CHECK((leftHeight - rightHeight <= 1) && (rightHeight - leftHeight <= 1));
+    CHECK(node->_size == 1 + leftSize + rightSize);
+    return node->_size;
+}
+
+/* Compares two binary keys: byte by byte, then by length. */
+int compareKeys(const AVLBinKey *key1, const AVLBinKey *key2) {
+    unsigned long int len = key1->len < key2->len ? key1->len : key2->len;
+    int comp = len > 0 ? memcmp(key1->bytes, key2->bytes, len) : 0;
+    if (comp != 0) return comp;
+    return (key1->len > key2->len) - (key1->len < key2->len);
+}
@@ -0,0 +1,225 @@
+/* AVL Trees library contributors
+ * Creation Date: 17/10/2026
+ * Latest Version: 17/10/2026
+ * ----------------------------------------------------------------------------
+ * This is a self-checking test program for the modules shared by all the
+ * flavours: the work-stealing pool, whose tasks must each run exactly once
+ * however they are spawned, stolen, nested or submitted, and the memory
+ * budgets, whose counts must stay exact under concurrent charges.
+ * Build and run it from this directory with:
+ *   gcc -std=gnu11 -O2 -pthread -I../AVLTrees_Common Test_Common.c
+ *       ../AVLTrees_Common/AVLTree_WorkPool.c
+ *       ../AVLTrees_Common/AVLTree_MemBudget.c
+ *       -o Test_Common && ./Test_Common
+ * It prints every failed check, and exits with 1 if there were any.
+ */
+/* This code is released under the MIT license.
+ * See the attached LICENSE file.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include "AVLTree_WorkPool.h"
+#include "AVLTree_MemBudget.h"
+
+/* Macro to record a failed check, telling where it is. */
+#define CHECK(COND) do {                                                    \
+    if (!(COND)) {                                                          \
+        fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__,   \
+                #COND);                                                     \
+        __atomic_add_fetch(&failures, 1, __ATOMIC_RELAXED);                 \
+    }                                                                       \
+} while (0)
+
+/* Number of threads that use the pools and the budgets at the same time. */
+#define THREADS 4
+
+/* A range of numbers to add up, and their sum. */
+typedef struct {
+    unsigned long int lo;
+    unsigned long int hi;
+    unsigned long int sum;
+    AVLWorkPool *inner;
+} SumRange;
+
+/* Test subroutines declarations. */
+void sumRange(void *arg);
+void sumNested(void *arg);
+void markIndex(void *arg, unsigned long int i);
+void *submitSums(void *arg);
+void pressure(AVLMemBudget *budget, unsigned long int bytes, void *ctx);
+void *chargeRandomly(void *arg);
+void testWorkPool(void);
+void testMemBudget(void);
+
+/* Number of failed checks. */
+int failures = 0;
+
+int main(void) {
+    testWorkPool();
+    testMemBudget();
+    if (failures > 0) {
+        printf("%d checks failed\n", failures);
+        return 1;
+    }
+    printf("All checks passed\n");
+    return 0;
+}
+
+// TESTS //
+/* Runs divide-and-conquer sums, deep enough to overflow the deques, loops,
+ * sums submitted by many threads at once, and sums that run on another pool
+ * from inside a task.
+ */
+void testWorkPool(void) {
+    AVLWorkPool *pool = createWorkPool(THREADS);
+    AVLWorkPool *other = createWorkPool(2);
+    CHECK((pool != NULL) && (other != NULL));
+    if ((pool == NULL) || (other == NULL)) return;
+    unsigned long int n = 1000000;
+    SumRange range = {0, n, 0, NULL};
+    CHECK(workPoolRun(pool, sumRange, &range) == 0);
+    CHECK(range.sum == n * (n - 1) / 2);
+    // Without a pool, everything runs in the calling thread.
+    range.sum = 0;
+    workPoolRun(NULL, sumRange, &range);
+    CHECK(range.sum == n * (n - 1) / 2);
+    unsigned long int sizes[4] = {0, 1, 7, 100000};
+    for (int i = 0; i < 4; i++) {
+        unsigned char *marks = calloc(sizes[i] + 1, 1);
+        workPoolFor(pool, markIndex, marks, sizes[i]);
+        for (unsigned long int j = 0; j < sizes[i]; j++)
+            CHECK(marks[j] == 1);
+        CHECK(marks[sizes[i]] == 0);
+        free(marks);
+    }
+    pthread_t threads[THREADS];
+    for (int i = 0; i < THREADS; i++)
+        pthread_create(&threads[i], NULL, submitSums, pool);
+    for (int i = 0; i < THREADS; i++) pthread_join(threads[i], NULL);
+    SumRange nested = {0, 64, 0, other};
+    CHECK(workPoolRun(pool, sumNested, &nested) == 0);
+    CHECK(nested.sum == 64 * (n * (n - 1) / 2));
+    deleteWorkPool(other);
+    deleteWorkPool(pool);
+}
+
+/* Checks charges, refusals, the pressure callback and peaks, then runs many
+ * threads charging and releasing the same budget.
+ */
+void testMemBudget(void) {
+    unsigned long int held = 0;
+    AVLMemBudget *budget = createMemBudget(1000, pressure, &held);
+    CHECK(memBudgetCharge(budget, 600) == 0);
+    held = 600;
+    // The callback gives back what's held, so this fits on the second try.
+    CHECK(memBudgetCharge(budget, 600) == 0);
+    CHECK((held == 0) && (budget->used == 600));
+    // Only the charge tried by the callback itself was refused.
+    CHECK(budget->refusals == 1);
+    held = 600;
+    // Quiet charges never call back.
+    CHECK(memBudgetTryCharge(budget, 600) == -1);
+    CHECK((held == 600) && (budget->refusals == 2));
+    CHECK(memBudgetTryCharge(budget, 400) == 0);
+    CHECK(budget->used == 1000);
+    memBudgetForce(budget, 500);
+    CHECK((budget->used == 1500) && (budget->peak == 1500));
+    memBudgetRelease(budget, 1500);
+    CHECK((budget->used == 0) && (budget->peak == 1500));
+    CHECK(memBudgetCharge(NULL, 1UL << 60) == 0);
+    deleteMemBudget(budget);
+    budget = createMemBudget(100000, NULL, NULL);
+    pthread_t threads[THREADS];
+    for (int i = 0; i < THREADS; i++)
+        pthread_create(&threads[i], NULL, chargeRandomly, budget);
+    for (int i = 0; i < THREADS; i++) pthread_join(threads[i], NULL);
+    CHECK(budget->used == 0);
+    CHECK(budget->peak <= budget->limit);
+    deleteMemBudget(budget);
+}
+
+// TEST SUBROUTINES //
+/* Adds up a range of numbers, splitting it in two tasks while it's big. */
+void sumRange(void *arg) {
+    SumRange *range = (SumRange *) arg;
+    if (range->hi - range->lo <= 64) {
+        range->sum = 0;
+        for (unsigned long int i = range->lo; i < range->hi; i++)
+            range->sum += i;
+        return;
+    }
+    unsigned long int mid = range->lo + (range->hi - range->lo) / 2;
+    SumRange left = {range->lo, mid, 0, NULL};
+    SumRange right = {mid, range->hi, 0, NULL};
+    AVLWorkTask task;
+    workPoolSpawn(&task, sumRange, &left);
+    sumRange(&right);
+    workPoolSync(&task);
+    range->sum = left.sum + right.sum;
+}
+
+/* Runs a whole sum on the inner pool for each number in the range, splitting
+ * the range in tasks of the outer one.
+ */
+void sumNested(void *arg) {
+    SumRange *range = (SumRange *) arg;
+    if (range->hi - range->lo == 1) {
+        SumRange inner = {0, 1000000, 0, NULL};
+        CHECK(workPoolRun(range->inner, sumRange, &inner) == 0);
+        range->sum = inner.sum;
+        return;
+    }
+    unsigned long int mid = range->lo + (range->hi - range->lo) / 2;
+    SumRange left = {range->lo, mid, 0, range->inner};
+    SumRange right = {mid, range->hi, 0, range->inner};
+    AVLWorkTask task;
+    workPoolSpawn(&task, sumNested, &left);
+    sumNested(&right);
+    workPoolSync(&task);
+    range->sum = left.sum + right.sum;
+}
+
+/* Marks an index as visited by a loop. */
+void markIndex(void *arg, unsigned long int i) {
+    __atomic_add_fetch(((unsigned char *) arg) + i, 1, __ATOMIC_RELAXED);
+}
+
+/* Submits many sums to a pool shared with other threads. */
+void *submitSums(void *arg) {
+    for (unsigned long int n = 1; n < 200000; n *= 3) {
+        SumRange range = {0, n, 0, NULL};
+        CHECK(workPoolRun((AVLWorkPool *) arg, sumRange, &range) == 0);
+        CHECK(range.sum == n * (n - 1) / 2);
+    }
+    return NULL;
+}
+
+/* Gives back to the budget all the bytes held, which are counted in ctx. */
+void pressure(AVLMemBudget *budget, unsigned long int bytes, void *ctx) {
+    unsigned long int *held = (unsigned long int *) ctx;
+    // Charges made while relieving the pressure don't call back again.
+    CHECK(memBudgetCharge(budget, bytes) == -1);
+    memBudgetRelease(budget, *held);
+    *held = 0;
+}
+
+/* Charges and releases random amounts, never more than it was given. */
+void *chargeRandomly(void *arg) {
+    AVLMemBudget *budget = (AVLMemBudget *) arg;
+    unsigned short rng[3] = {1, 2, (unsigned short) pthread_self()};
+    unsigned long int held = 0, bytes;
+    for (int i = 0; i < 100000; i++) {
+        bytes = (unsigned long int) (nrand48(rng) % 1000);
+        if ((nrand48(rng) % 2) && (memBudgetCharge(budget, bytes) == 0)) {
+            held += bytes;
+        } else if (held >= bytes) {
+            memBudgetRelease(budget, bytes);
+            held -= bytes;
+        }
+    }
+    memBudgetRelease(budget, held);
+    return NULL;
+}
@@ -0,0 +1,489 @@
+/* AVL Trees library contributors
+ * Creation Date: 17/10/2026
+ * Latest Version: 17/10/2026
+ * ----------------------------------------------------------------------------
+ * This is a self-checking test program for the integer keys flavour, its
+ * asynchronous write path and its interval trees. Random sequences of
+ * insertions and deletions are run against a reference count of the keys,
+ * with every combination of cache, hash index, buffer and eviction policy,
+ * and after each batch the whole structure of the tree is checked: ordering,
+ * heights and balance, subtree sizes, father links, extremes, the LRU list,
+ * the hash index, the cache and the memory count.
+ * Build and run it from this directory with:
+ *   gcc -std=gnu11 -O2 -pthread -I../AVLTrees_Common
+ *       -I../AVLTrees_IntegerKeys Test_IntegerKeys.c
+ *       ../AVLTrees_IntegerKeys/AVLTree_IntegerKeys*.c
+ *       ../AVLTrees_Common/AVLTree_WorkPool.c
+ *       ../AVLTrees_Common/AVLTree_MemBudget.c
+ *       -o Test_IntegerKeys && ./Test_IntegerKeys
+ * It prints every failed check, and exits with 1 if there were any.
+ */
+/* This code is released under the MIT license.
+ * See the attached LICENSE file.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sched.h>
+#include <pthread.h>
+#include "AVLTree_IntegerKeys.h"
+#include "AVLTree_IntegerKeys_Async.h"
+#include "AVLTree_IntegerKeys_Intervals.h"
+
+/* Macro to record a failed check, telling where it is. */
+#define CHECK(COND) do {                                                    \
+    if (!(COND)) {                                                          \
+        fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__,   \
+                #COND);                                                     \
+        failures++;                                                         \
+    }                                                                       \
+} while (0)
+
+/* Macro to turn a key into the data it's stored with, so that every entry
+ * found can be checked against its key.
+ */
+#define KEY_DATA(KEY) ((void *) (long int) (2 * (long int) (KEY) + 1))
+
+/* Range of the keys used by the random workloads: small enough to get many
+ * duplicates and deletions of keys that are there.
+ */
+#define KEY_RANGE 2000
+
+/* Library internals used to check the hash index and the cache. */
+unsigned long int _intIndexHome(int bits, int key);
+unsigned long int _intCacheSlot(AVLIntTree *tree, int key);
+
+/* Test subroutines declarations. */
+unsigned long int checkIntSubtree(AVLIntNode *node, AVLIntNode *father,
+                                  int *min, int *max, AVLIntNode ***nodes);
+int comparePointers(const void *ptr1, const void *ptr2);
+int compareInts(const void *int1, const void *int2);
+void checkIntTree(AVLIntTree *tree);
+void runWorkload(AVLIntTree *tree, unsigned short rng[3], int rounds,
+                 int evicting);
+void testWorkloads(void);
+void testBuildParallel(void);
+void testParallelVisits(void);
+void *produce(void *arg);
+void testAsync(void);
+void countInterval(AVLIntInterval *interval, void *ctx);
+void testIntervals(void);
+
+/* Number of failed checks. */
+int failures = 0;
+
+int main(void) {
+    testWorkloads();
+    testBuildParallel();
+    testParallelVisits();
+    testAsync();
+    testIntervals();
+    if (failures > 0) {
+        printf("%d checks failed\n", failures);
+        return 1;
+    }
+    printf("All checks passed\n");
+    return 0;
+}
+
+// TESTS //
+/* Runs the random workload on trees with every combination of cache, index
+ * and buffer, then on trees that evict entries, with and without a budget.
+ */
+void testWorkloads(void) {
+    unsigned short rng[3] = {0x1234, 0x5678, 0x9ABC};
+    AVLMemBudget *budget = createMemBudget(1UL << 30, NULL, NULL);
+    AVLIntTree *tree;
+    for (int setup = 0; setup < 8; setup++) {
+        tree = createIntTree();
+        if (setup & 0x1) intSetCache(tree, 64);
+        if (setup & 0x2) intSetIndex(tree, 1);
+        if (setup & 0x4) intSetBuffer(tree, 16);
+        if (setup == 7) intSetBudget(tree, budget);
+        runWorkload(tree, rng, 40, 0);
+        // Settings changed while the tree is full must keep it consistent.
+        intSetCache(tree, (setup & 0x1) ? 0 : 1000);
+        intSetIndex(tree, !(setup & 0x2));
+        runWorkload(tree, rng, 10, 0);
+        CHECK(intSetBudget(tree, NULL) == 0);
+        deleteIntTree(tree, 0);
+    }
+    CHECK(budget->used == 0);
+    int policies[3] = {EVICT_MIN_KEY, EVICT_MAX_KEY, EVICT_LRU};
+    for (int i = 0; i < 3; i++) {
+        tree = createIntTree();
+        intSetCapacity(tree, 300, policies[i], 0);
+        intSetCache(tree, 128);
+        intSetIndex(tree, 1);
+        intSetBudget(tree, budget);
+        runWorkload(tree, rng, 40, 1);
+        CHECK(tree->nodesCount <= 300);
+        CHECK(intSetBudget(tree, NULL) == 0);
+        deleteIntTree(tree, 0);
+    }
+    CHECK(budget->used == 0);
+    deleteMemBudget(budget);
+}
+
+/* Builds trees in parallel from unsorted keys, duplicates included, and
+ * checks that they hold exactly the given entries, in order.
+ */
+void testBuildParallel(void) {
+    unsigned long int sizes[6] = {0, 1, 2, 3, 1000, 100000};
+    AVLWorkPool *pool = createWorkPool(4);
+    unsigned short rng[3] = {7, 8, 9};
+    for (int i = 0; i < 6; i++) {
+        unsigned long int n = sizes[i];
+        int *keys = malloc((n + 1) * sizeof(int));
+        void **data = malloc((n + 1) * sizeof(void *));
+        for (unsigned long int j = 0; j < n; j++) {
+            keys[j] = (int) (nrand48(rng) % (n + 1)) - (int) (n / 2);
+            data[j] = KEY_DATA(keys[j]);
+        }
+        for (int parallel = 0; parallel < 2; parallel++) {
+            AVLIntTree *tree = intBuildParallel(keys, data, n,
+                                                parallel ? pool : NULL);
+            CHECK(tree != NULL);
+            if (tree == NULL) continue;
+            CHECK(tree->nodesCount == n);
+            checkIntTree(tree);
+            if (n > 0) {
+                int *sorted = malloc(n * sizeof(int));
+                memcpy(sorted, keys, n * sizeof(int));
+                qsort(sorted, n, sizeof(int), compareInts);
+                int *inOrder = (int *) intDFS(tree, DFS_IN_ORDER,
+                                              SEARCH_KEYS);
+                void **inData = intDFS(tree, DFS_IN_ORDER, SEARCH_DATA);
+                CHECK(memcmp(inOrder, sorted, n * sizeof(int)) == 0);
+                for (unsigned long int j = 0; j < n; j++)
+                    CHECK(inData[j] == KEY_DATA(inOrder[j]));
+                free(sorted);
+                free(inOrder);
+                free(inData);
+            }
+            deleteIntTree(tree, 0);
+        }
+        free(keys);
+        free(data);
+    }
+    deleteWorkPool(pool);
+}
+
+/* Checks that parallel visits return the same arrays as sequential ones. */
+void testParallelVisits(void) {
+    AVLWorkPool *pool = createWorkPool(4);
+    unsigned short rng[3] = {3, 1, 4};
+    AVLIntTree *tree = createIntTree();
+    for (int i = 0; i < 50000; i++) {
+        int key = (int) (nrand48(rng) % 100000);
+        intInsert(tree, key, KEY_DATA(key));
+    }
+    int types[5] = {DFS_PRE_ORDER, DFS_IN_ORDER, DFS_POST_ORDER,
+                    BFS_LEFT_FIRST, BFS_RIGHT_FIRST};
+    for (int i = 0; i < 5; i++) {
+        int bfs = (types[i] == BFS_LEFT_FIRST) ||
+                  (types[i] == BFS_RIGHT_FIRST);
+        int *seq = (int *) (bfs ? intBFS(tree, types[i], SEARCH_KEYS) :
+                            intDFS(tree, types[i], SEARCH_KEYS));
+        int *par = (int *) (bfs ?
+                            intParallelBFS(tree, types[i], SEARCH_KEYS, pool) :
+                            intParallelDFS(tree, types[i], SEARCH_KEYS, pool));
+        CHECK((seq != NULL) && (par != NULL));
+        if ((seq != NULL) && (par != NULL))
+            CHECK(memcmp(seq, par, tree->nodesCount * sizeof(int)) == 0);
+        free(seq);
+        free(par);
+    }
+    deleteIntTree(tree, 0);
+    deleteWorkPool(pool);
+}
+
+/* Number of producers of the asynchronous tree, and of keys each one adds. */
+#define PRODUCERS 4
+#define PRODUCED 20000
+
+/* Queues the insertion of the keys of a producer, then the deletion of the
+ * even ones, retrying while the ring buffer is full.
+ */
+void *produce(void *arg) {
+    AVLIntAsyncTree *async = ((void **) arg)[0];
+    int first = (int) (long int) ((void **) arg)[1];
+    for (int i = 0; i < PRODUCED; i++) {
+        while (intAsyncInsert(async, first + i, KEY_DATA(first + i)) != 0)
+            sched_yield();
+    }
+    for (int i = 0; i < PRODUCED; i += 2) {
+        while (intAsyncDelete(async, first + i) != 0) sched_yield();
+    }
+    return NULL;
+}
+
+/* Runs many producers on an asynchronous tree, whose small ring buffer makes
+ * them wrap around it many times, and checks that every operation was applied
+ * exactly once.
+ */
+void testAsync(void) {
+    AVLIntAsyncTree *async = createIntAsyncTree(createIntTree(), 256, 32, 0,
+                                                0);
+    CHECK(async != NULL);
+    if (async == NULL) return;
+    pthread_t producers[PRODUCERS];
+    void *args[PRODUCERS][2];
+    for (int i = 0; i < PRODUCERS; i++) {
+        args[i][0] = async;
+        args[i][1] = (void *) (long int) (i * 1000000);
+        pthread_create(&producers[i], NULL, produce, args[i]);
+    }
+    for (int i = 0; i < PRODUCERS; i++) pthread_join(producers[i], NULL);
+    CHECK(intAsyncFlush(async) == 0);
+    CHECK(async->failedOps == 0);
+    AVLIntSnapshot *snap = intAcquireSnapshot(async);
+    CHECK(snap->count == PRODUCERS * PRODUCED / 2);
+    for (unsigned long int i = 1; i < snap->count; i++)
+        CHECK(snap->keys[i - 1] < snap->keys[i]);
+    for (int i = 0; i < PRODUCERS; i++) {
+        for (int j = 0; j < PRODUCED; j++) {
+            void *found = intSnapshotSearch(snap, i * 1000000 + j,
+                                            SEARCH_DATA);
+            CHECK(found == ((j % 2) ? KEY_DATA(i * 1000000 + j) : NULL));
+        }
+    }
+    intReleaseSnapshot(snap);
+    AVLIntTree *tree = deleteIntAsyncTree(async);
+    CHECK(tree->nodesCount == PRODUCERS * PRODUCED / 2);
+    checkIntTree(tree);
+    deleteIntTree(tree, 0);
+}
+
+/* Counts an interval found by a query. */
+void countInterval(AVLIntInterval *interval, void *ctx) {
+    (void) interval;
+    (*((unsigned long int *) ctx))++;
+}
+
+/* Checks stabbing and overlap queries against a brute force search, while
+ * intervals are inserted and deleted at random.
+ */
+void testIntervals(void) {
+    unsigned short rng[3] = {2, 7, 1};
+    AVLIntIntervalTree *itree = createIntIntervalTree();
+    int lows[3000], highs[3000];
+    int count = 0;
+    for (int round = 0; round < 20; round++) {
+        for (int i = 0; i < 300; i++) {
+            if ((count < 3000) && (nrand48(rng) % 3 != 0)) {
+                lows[count] = (int) (nrand48(rng) % 1000);
+                highs[count] = lows[count] + (int) (nrand48(rng) % 100);
+                intIntervalInsert(itree, lows[count], highs[count], NULL);
+                count++;
+            } else if (count > 0) {
+                int victim = (int) (nrand48(rng) % count);
+                CHECK(intIntervalDelete(itree, lows[victim], highs[victim],
+                                        0) == 1);
+                count--;
+                lows[victim] = lows[count];
+                highs[victim] = highs[count];
+            }
+        }
+        CHECK(itree->intervalsCount == (unsigned long int) count);
+        checkIntTree(itree->_tree);
+        for (int i = 0; i < 100; i++) {
+            int lo = (int) (nrand48(rng) % 1200) - 100;
+            int hi = lo + (int) (nrand48(rng) % 50);
+            unsigned long int stabs = 0, overlaps = 0, expStabs = 0,
+                              expOverlaps = 0;
+            for (int j = 0; j < count; j++) {
+                if ((lows[j] <= lo) && (lo <= highs[j])) expStabs++;
+                if ((lows[j] <= hi) && (lo <= highs[j])) expOverlaps++;
+            }
+            CHECK(intIntervalStab(itree, lo, countInterval, &stabs) ==
+                  expStabs);
+            CHECK(stabs == expStabs);
+            CHECK(intIntervalOverlap(itree, lo, hi, countInterval,
+                                     &overlaps) == expOverlaps);
+            CHECK(overlaps == expOverlaps);
+        }
+    }
+    deleteIntIntervalTree(itree, 0);
+}
+
+// TEST SUBROUTINES //
+/* Runs random insertions, deletions and searches on a tree, checking the
+ * results against a count of the keys in it, and the whole tree after each
+ * round. Trees that evict entries can lose any of them, so only what is found
+ * is checked.
+ */
+void runWorkload(AVLIntTree *tree, unsigned short rng[3], int rounds,
+                 int evicting) {
+    static unsigned long int counts[KEY_RANGE];
+    memset(counts, 0, sizeof(counts));
+    // Start from what is already in the tree.
+    intFlushBuffer(tree);
+    int *present = (int *) intDFS(tree, DFS_IN_ORDER, SEARCH_KEYS);
+    for (unsigned long int i = 0; (present != NULL) && (i < tree->nodesCount);
+         i++)
+        counts[present[i]]++;
+    free(present);
+    for (int round = 0; round < rounds; round++) {
+        for (int i = 0; i < 1000; i++) {
+            int key = (int) (nrand48(rng) % KEY_RANGE);
+            long int op = nrand48(rng) % 10;
+            if (op < 4) {
+                unsigned long int inserted =
+                    (op == 0) ? intFingerInsert(tree, NULL, key,
+                                                KEY_DATA(key)) :
+                                intInsert(tree, key, KEY_DATA(key));
+                CHECK(inserted > 0);
+                counts[key]++;
+            } else if (op < 7) {
+                int deleted = intDelete(tree, key, 0);
+                if (!evicting) CHECK(deleted == (counts[key] > 0));
+                if (counts[key] > 0) counts[key]--;
+            } else if (op < 9) {
+                void *found = intSearch(tree, key, SEARCH_DATA);
+                if (!evicting) CHECK((found != NULL) == (counts[key] > 0));
+                if (found != NULL) CHECK(found == KEY_DATA(key));
+            } else {
+                int popped;
+                void *data;
+                if (((key % 2) ? intPopMin : intPopMax)(tree, &popped,
+                                                        &data) == 1) {
+                    CHECK(data == KEY_DATA(popped));
+                    if (counts[popped] > 0) counts[popped]--;
+                }
+            }
+        }
+        checkIntTree(tree);
+        if (round % 4 == 0) {
+            CHECK(intFlushBuffer(tree) == 0);
+            checkIntTree(tree);
+        }
+    }
+    CHECK(intFlushBuffer(tree) == 0);
+    if (!evicting) {
+        unsigned long int total = 0;
+        for (int key = 0; key < KEY_RANGE; key++) total += counts[key];
+        CHECK(tree->nodesCount == total);
+    }
+}
+
+/* Checks everything that can be checked in a tree and its structures. */
+void checkIntTree(AVLIntTree *tree) {
+    AVLIntNode **nodes = malloc((tree->nodesCount + 1) *
+                                sizeof(AVLIntNode *));
+    AVLIntNode **next = nodes;
+    int min, max;
+    unsigned long int size = 0;
+    if (tree->_root != NULL) {
+        size = checkIntSubtree(tree->_root, NULL, &min, &max, &next);
+        CHECK(tree->_minNode == nodes[0]);
+        CHECK(tree->_maxNode == nodes[size - 1]);
+    }
+    CHECK(size + tree->_buffered == tree->nodesCount);
+    CHECK((unsigned long int) (next - nodes) == size);
+    for (unsigned long int i = 1; i < tree->_buffered; i++)
+        CHECK(tree->_bufKeys[i - 1] <= tree->_bufKeys[i]);
+    // Nodes are collected in order: sort them by address to look them up.
+    qsort(nodes, size, sizeof(AVLIntNode *), comparePointers);
+    if (tree->_evictPolicy & EVICT_LRU) {
+        unsigned long int listed = 0;
+        AVLIntNode *last = NULL;
+        for (AVLIntNode *curr = tree->_newest; curr != NULL;
+             curr = curr->_older) {
+            CHECK(curr->_newer == last);
+            last = curr;
+            if (++listed > size) break;
+        }
+        CHECK(listed == size);
+        CHECK(tree->_oldest == last);
+    }
+    if (tree->_index != NULL) {
+        unsigned long int slots = 1UL << tree->_indexBits, used = 0;
+        for (unsigned long int i = 0; i < slots; i++) {
+            AVLIntIndexSlot *slot = tree->_index + i;
+            if (slot->_node == NULL) continue;
+            used++;
+            CHECK(bsearch(&(slot->_node), nodes, size, sizeof(AVLIntNode *),
+                          comparePointers) != NULL);
+            CHECK(slot->_key == slot->_node->_key);
+            // Probing from the key's home must reach it without a hole.
+            for (unsigned long int j = _intIndexHome(tree->_indexBits,
+                                                     slot->_key);
+                 j != i; j = (j + 1) & (slots - 1)) {
+                if (tree->_index[j]._node == NULL) {
+                    CHECK(tree->_index[j]._node != NULL);
+                    break;
+                }
+            }
+        }
+        CHECK(used == size);
+        CHECK(tree->_indexUsed == size);
+    }
+    unsigned long int memory = sizeof(AVLIntTree) + tree->nodesCount *
+                               (sizeof(AVLIntNode) + tree->_augment.augSize) +
+                               tree->_bufCapacity * (sizeof(int) +
+                                                     sizeof(void *)) +
+                               intIndexMemory(tree);
+    if (tree->_cache != NULL) {
+        unsigned long int slots = 1UL << tree->_cacheBits;
+        memory += slots * sizeof(AVLIntNode *);
+        for (unsigned long int i = 0; i < slots; i++) {
+            AVLIntNode *cached = tree->_cache[i];
+            if (cached == NULL) continue;
+            CHECK(bsearch(&cached, nodes, size, sizeof(AVLIntNode *),
+                          comparePointers) != NULL);
+        }
+    }
+    CHECK(tree->memUsed == memory);
+    if (tree->_budget != NULL) CHECK(tree->_budget->used >= tree->memUsed);
+    free(nodes);
+}
+
+/* Checks the subtree rooted in a node: father links, ordering, heights,
+ * balance and sizes. Its nodes are stored in order where nodes points, and
+ * its smallest and greatest keys where min and max do.
+ * Returns the number of nodes in the subtree.
+ */
+unsigned long int checkIntSubtree(AVLIntNode *node, AVLIntNode *father,
+                                  int *min, int *max, AVLIntNode ***nodes) {
+    int leftMin, leftMax, rightMin, rightMax;
+    unsigned long int leftSize = 0, rightSize = 0;
+    int leftHeight = -1, rightHeight = -1;
+    CHECK(node->_father == father);
+    *min = node->_key;
+    *max = node->_key;
+    if (node->_leftSon != NULL) {
+        leftSize = checkIntSubtree(node->_leftSon, node, &leftMin, &leftMax,
+                                   nodes);
+        CHECK(leftMax <= node->_key);
+        leftHeight = node->_leftSon->_height;
+        *min = leftMin;
+    }
+    *((*nodes)++) = node;
+    if (node->_rightSon != NULL) {
+        rightSize = checkIntSubtree(node->_rightSon, node, &rightMin,
+                                    &rightMax, nodes);
+        CHECK(rightMin >= node->_key);
+        rightHeight = node->_rightSon->_height;
+        *max = rightMax;
+    }
+    CHECK(node->_height == 1 + (leftHeight > rightHeight ? leftHeight :
+                                rightHeight));
+    CHECK((leftHeight - rightHeight <= 1) && (rightHeight - leftHeight <= 1));
+    CHECK(node->_size == 1 + leftSize + rightSize);
+    return node->_size;
+}
+
+/* Compares two node pointers by address, for qsort and bsearch. */
+int comparePointers(const void *ptr1, const void *ptr2) {
+    AVLIntNode *node1 = *((AVLIntNode * const *) ptr1);
+    AVLIntNode *node2 = *((AVLIntNode * const *) ptr2);
+    return (node1 > node2) - (node1 < node2);
+}
+
+/* Compares two integers, for qsort. */
+int compareInts(const void *int1, const void *int2) {
+    int first = *((const int *) int1), second = *((const int *) int2);
+    return (first > second) - (first < second);
+}
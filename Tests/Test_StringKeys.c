@@ -0,0 +1,350 @@
+/* AVL Trees library contributors
+ * Creation Date: 17/10/2026
+ * Latest Version: 17/10/2026
+ * ----------------------------------------------------------------------------
+ * This is a self-checking test program for the string keys flavour. Random
+ * sequences of insertions and deletions are run against a reference count of
+ * the keys, with and without cache, normalizers and prefix skipping, through
+ * migrations too, and after each batch the whole structure of the tree is
+ * checked: ordering, heights and balance, subtree sizes, father links, the
+ * cache and the memory count. Trees built in parallel, and parallel visits,
+ * are checked against sequential ones.
+ * Build and run it from this directory with:
+ *   gcc -std=gnu11 -O2 -pthread -I../AVLTrees_Common
+ *       -I../AVLTrees_StringKeys Test_StringKeys.c
+ *       ../AVLTrees_StringKeys/AVLTree_StringKeys.c
+ *       ../AVLTrees_Common/AVLTree_WorkPool.c
+ *       ../AVLTrees_Common/AVLTree_MemBudget.c
+ *       -o Test_StringKeys && ./Test_StringKeys
+ * It prints every failed check, and exits with 1 if there were any.
+ */
+/* This code is released under the MIT license.
+ * See the attached LICENSE file.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "AVLTree_StringKeys.h"
+
+/* Macro to record a failed check, telling where it is. */
+#define CHECK(COND) do {                                                    \
+    if (!(COND)) {                                                          \
+        fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__,   \
+                #COND);                                                     \
+        failures++;                                                         \
+    }                                                                       \
+} while (0)
+
+/* Macro to turn the number of a key into the data it's stored with, so that
+ * every entry found can be checked against its key.
+ */
+#define KEY_DATA(NUM) ((void *) (long int) (2 * (long int) (NUM) + 1))
+
+/* Number of different keys used by the random workloads: small enough to get
+ * many duplicates and deletions of keys that are there.
+ */
+#define KEY_RANGE 2000
+
+/* Test subroutines declarations. */
+void makeKeys(void);
+int compareKeys(AVLStrNode *node1, AVLStrNode *node2);
+unsigned long int checkStrSubtree(AVLStrNode *node, AVLStrNode *father,
+                                  AVLStrNode **min, AVLStrNode **max,
+                                  AVLStrNode ***nodes);
+int comparePointers(const void *ptr1, const void *ptr2);
+int compareStrings(const void *str1, const void *str2);
+void checkStrTree(AVLStrTree *tree);
+void runWorkload(AVLStrTree *tree, AVLStrMigration *mig,
+                 unsigned short rng[3], int rounds);
+void testWorkloads(void);
+void testMigration(void);
+void testBuildParallel(void);
+void testParallelVisits(void);
+
+/* Number of failed checks. */
+int failures = 0;
+
+/* Keys used by the workloads, and their numbers. */
+char *keys[KEY_RANGE];
+unsigned long int counts[KEY_RANGE];
+
+int main(void) {
+    makeKeys();
+    testWorkloads();
+    testMigration();
+    testBuildParallel();
+    testParallelVisits();
+    for (int i = 0; i < KEY_RANGE; i++) free(keys[i]);
+    if (failures > 0) {
+        printf("%d checks failed\n", failures);
+        return 1;
+    }
+    printf("All checks passed\n");
+    return 0;
+}
+
+// TESTS //
+/* Runs the random workload on trees with every combination of cache and key
+ * comparison strategy, one of them charged to a budget.
+ */
+void testWorkloads(void) {
+    unsigned short rng[3] = {0x1234, 0x5678, 0x9ABC};
+    AVLMemBudget *budget = createMemBudget(1UL << 30, NULL, NULL);
+    for (int setup = 0; setup < 8; setup++) {
+        AVLStrTree *tree = createStrTree();
+        if (setup & 0x1) strSetCache(tree, 64);
+        if ((setup & 0x6) == 0x2) strSetNormalizer(tree, strKeyPrefix, NULL);
+        if ((setup & 0x6) == 0x4) strSetNormalizer(tree, strKeyHash, NULL);
+        if ((setup & 0x6) == 0x6) strSetPrefixSkip(tree, 1);
+        if (setup == 7) strSetBudget(tree, budget);
+        memset(counts, 0, sizeof(counts));
+        runWorkload(tree, NULL, rng, 40);
+        CHECK(strSetBudget(tree, NULL) == 0);
+        deleteStrTree(tree, 0);
+    }
+    CHECK(budget->used == 0);
+    deleteMemBudget(budget);
+}
+
+/* Runs the random workload through a migration between trees that order
+ * their keys differently, checking both trees as entries move.
+ */
+void testMigration(void) {
+    unsigned short rng[3] = {5, 6, 7};
+    AVLMemBudget *budget = createMemBudget(1UL << 30, NULL, NULL);
+    AVLStrTree *from = createStrTree(), *to = createStrTree();
+    strSetCache(from, 256);
+    strSetNormalizer(to, strKeyHash, NULL);
+    strSetBudget(from, budget);
+    strSetBudget(to, budget);
+    memset(counts, 0, sizeof(counts));
+    runWorkload(from, NULL, rng, 10);
+    AVLStrMigration *mig = strStartMigration(from, to, 3);
+    runWorkload(from, mig, rng, 20);
+    CHECK(strFinishMigration(mig) == 0);
+    checkStrTree(to);
+    unsigned long int total = 0;
+    for (int i = 0; i < KEY_RANGE; i++) total += counts[i];
+    CHECK(to->nodesCount == total);
+    CHECK(budget->used == to->memUsed);
+    CHECK(strSetBudget(to, NULL) == 0);
+    deleteStrTree(to, 0);
+    deleteMemBudget(budget);
+}
+
+/* Builds trees in parallel from unsorted keys, duplicates included, and
+ * checks that they hold exactly the given entries, in order.
+ */
+void testBuildParallel(void) {
+    unsigned long int sizes[6] = {0, 1, 2, 3, 1000, 50000};
+    AVLWorkPool *pool = createWorkPool(4);
+    unsigned short rng[3] = {7, 8, 9};
+    for (int i = 0; i < 6; i++) {
+        unsigned long int n = sizes[i];
+        char **input = malloc((n + 1) * sizeof(char *));
+        void **data = malloc((n + 1) * sizeof(void *));
+        for (unsigned long int j = 0; j < n; j++) {
+            long int num = nrand48(rng) % KEY_RANGE;
+            input[j] = keys[num];
+            data[j] = KEY_DATA(num);
+        }
+        for (int parallel = 0; parallel < 2; parallel++) {
+            AVLStrTree *tree = strBuildParallel(input, data, n,
+                                                parallel ? pool : NULL);
+            CHECK(tree != NULL);
+            if (tree == NULL) continue;
+            CHECK(tree->nodesCount == n);
+            checkStrTree(tree);
+            if (n > 0) {
+                char **sorted = malloc(n * sizeof(char *));
+                memcpy(sorted, input, n * sizeof(char *));
+                qsort(sorted, n, sizeof(char *), compareStrings);
+                char **inOrder = (char **) strDFS(tree, DFS_IN_ORDER,
+                                                  SEARCH_KEYS);
+                void **inData = strDFS(tree, DFS_IN_ORDER, SEARCH_DATA);
+                for (unsigned long int j = 0; j < n; j++) {
+                    CHECK(strcmp(inOrder[j], sorted[j]) == 0);
+                    long int num = ((long int) inData[j] - 1) / 2;
+                    CHECK((num >= 0) && (num < KEY_RANGE) &&
+                          (keys[num] == inOrder[j]));
+                }
+                free(sorted);
+                free(inOrder);
+                free(inData);
+            }
+            deleteStrTree(tree, 0);
+        }
+        free(input);
+        free(data);
+    }
+    deleteWorkPool(pool);
+}
+
+/* Checks that parallel visits return the same arrays as sequential ones. */
+void testParallelVisits(void) {
+    AVLWorkPool *pool = createWorkPool(4);
+    unsigned short rng[3] = {3, 1, 4};
+    AVLStrTree *tree = createStrTree();
+    for (int i = 0; i < 20000; i++) {
+        long int num = nrand48(rng) % KEY_RANGE;
+        strInsert(tree, keys[num], KEY_DATA(num));
+    }
+    int types[5] = {DFS_PRE_ORDER, DFS_IN_ORDER, DFS_POST_ORDER,
+                    BFS_LEFT_FIRST, BFS_RIGHT_FIRST};
+    for (int i = 0; i < 5; i++) {
+        int bfs = (types[i] == BFS_LEFT_FIRST) ||
+                  (types[i] == BFS_RIGHT_FIRST);
+        void **seq = bfs ? strBFS(tree, types[i], SEARCH_NODES) :
+                           strDFS(tree, types[i], SEARCH_NODES);
+        void **par = bfs ?
+                     strParallelBFS(tree, types[i], SEARCH_NODES, pool) :
+                     strParallelDFS(tree, types[i], SEARCH_NODES, pool);
+        CHECK((seq != NULL) && (par != NULL));
+        if ((seq != NULL) && (par != NULL))
+            CHECK(memcmp(seq, par, tree->nodesCount * sizeof(void *)) == 0);
+        free(seq);
+        free(par);
+    }
+    deleteStrTree(tree, 0);
+    deleteWorkPool(pool);
+}
+
+// TEST SUBROUTINES //
+/* Makes the keys used by the workloads: many of them share long prefixes,
+ * and their lengths vary, so that comparisons end at every position.
+ */
+void makeKeys(void) {
+    const char *prefixes[4] = {"", "a", "/usr/local/share/applications/",
+                               "/usr/local/share/applications/x/"};
+    for (int i = 0; i < KEY_RANGE; i++) {
+        keys[i] = malloc(64);
+        snprintf(keys[i], 64, "%s%d%.*s", prefixes[i % 4], i / 4,
+                 (i * 7) % 13, "zzzzzzzzzzzzz");
+    }
+}
+
+/* Runs random insertions, deletions and searches on a tree, or through a
+ * migration if there's one, checking the results against the count of the
+ * keys, and the trees after each round.
+ */
+void runWorkload(AVLStrTree *tree, AVLStrMigration *mig,
+                 unsigned short rng[3], int rounds) {
+    for (int round = 0; round < rounds; round++) {
+        for (int i = 0; i < 1000; i++) {
+            long int num = nrand48(rng) % KEY_RANGE;
+            long int op = nrand48(rng) % 10;
+            if (op < 4) {
+                CHECK((mig != NULL ?
+                       strMigrationInsert(mig, keys[num], KEY_DATA(num)) :
+                       strInsert(tree, keys[num], KEY_DATA(num))) > 0);
+                counts[num]++;
+            } else if (op < 7) {
+                int deleted = mig != NULL ?
+                              strMigrationDelete(mig, keys[num], 0) :
+                              strDelete(tree, keys[num], 0);
+                CHECK(deleted == (counts[num] > 0));
+                if (counts[num] > 0) counts[num]--;
+            } else {
+                // Keys are looked for through copies, not the same pointers.
+                char copy[64];
+                strcpy(copy, keys[num]);
+                void *found = mig != NULL ?
+                              strMigrationSearch(mig, copy, SEARCH_DATA) :
+                              strSearch(tree, copy, SEARCH_DATA);
+                CHECK((found != NULL) == (counts[num] > 0));
+                if (found != NULL) CHECK(found == KEY_DATA(num));
+            }
+        }
+        if (mig != NULL) {
+            checkStrTree(mig->_from);
+            checkStrTree(mig->_to);
+        } else checkStrTree(tree);
+    }
+}
+
+/* Checks everything that can be checked in a tree and its cache. */
+void checkStrTree(AVLStrTree *tree) {
+    AVLStrNode **nodes = malloc((tree->nodesCount + 1) *
+                                sizeof(AVLStrNode *));
+    AVLStrNode **next = nodes;
+    AVLStrNode *min, *max;
+    unsigned long int size = 0;
+    unsigned long int memory = sizeof(AVLStrTree);
+    if (tree->_root != NULL)
+        size = checkStrSubtree(tree->_root, NULL, &min, &max, &next);
+    CHECK(size == tree->nodesCount);
+    CHECK((unsigned long int) (next - nodes) == size);
+    for (unsigned long int i = 0; i < size; i++)
+        memory += sizeof(AVLStrNode) + strlen(nodes[i]->_key) + 1;
+    qsort(nodes, size, sizeof(AVLStrNode *), comparePointers);
+    if (tree->_cache != NULL) {
+        unsigned long int slots = 1UL << tree->_cacheBits;
+        memory += slots * sizeof(AVLStrNode *);
+        for (unsigned long int i = 0; i < slots; i++) {
+            AVLStrNode *cached = tree->_cache[i];
+            if (cached == NULL) continue;
+            CHECK(bsearch(&cached, nodes, size, sizeof(AVLStrNode *),
+                          comparePointers) != NULL);
+        }
+    }
+    CHECK(tree->memUsed == memory);
+    free(nodes);
+}
+
+/* Checks the subtree rooted in a node: father links, ordering, heights,
+ * balance and sizes. Its nodes are stored in order where nodes points, and
+ * those with its smallest and greatest keys where min and max do.
+ * Returns the number of nodes in the subtree.
+ */
+unsigned long int checkStrSubtree(AVLStrNode *node, AVLStrNode *father,
+                                  AVLStrNode **min, AVLStrNode **max,
+                                  AVLStrNode ***nodes) {
+    AVLStrNode *leftMin, *leftMax, *rightMin, *rightMax;
+    unsigned long int leftSize = 0, rightSize = 0;
+    int leftHeight = -1, rightHeight = -1;
+    CHECK(node->_father == father);
+    *min = node;
+    *max = node;
+    if (node->_leftSon != NULL) {
+        leftSize = checkStrSubtree(node->_leftSon, node, &leftMin, &leftMax,
+                                   nodes);
+        CHECK(compareKeys(leftMax, node) <= 0);
+        leftHeight = node->_leftSon->_height;
+        *min = leftMin;
+    }
+    *((*nodes)++) = node;
+    if (node->_rightSon != NULL) {
+        rightSize = checkStrSubtree(node->_rightSon, node, &rightMin,
+                                    &rightMax, nodes);
+        CHECK(compareKeys(rightMin, node) >= 0);
+        rightHeight = node->_rightSon->_height;
+        *max = rightMax;
+    }
+    CHECK(node->_height == 1 + (leftHeight > rightHeight ? leftHeight :
+                                rightHeight));
+    CHECK((leftHeight - rightHeight <= 1) && (rightHeight - leftHeight <= 1));
+    CHECK(node->_size == 1 + leftSize + rightSize);
+    return node->_size;
+}
+
+/* Compares the keys of two nodes as trees order them: by their normalized
+ * values first (all zeros without a normalizer), then as strings.
+ */
+int compareKeys(AVLStrNode *node1, AVLStrNode *node2) {
+    if (node1->_norm != node2->_norm)
+        return node1->_norm > node2->_norm ? 1 : -1;
+    return strcmp(node1->_key, node2->_key);
+}
+
+/* Compares two node pointers by address, for qsort and bsearch. */
+int comparePointers(const void *ptr1, const void *ptr2) {
+    AVLStrNode *node1 = *((AVLStrNode * const *) ptr1);
+    AVLStrNode *node2 = *((AVLStrNode * const *) ptr2);
+    return (node1 > node2) - (node1 < node2);
+}
+
+/* Compares two strings, for qsort. */
+int compareStrings(const void *str1, const void *str2) {
+    return strcmp(*((char * const *) str1), *((char * const *) str2));
+}